@@ -158,6 +158,9 @@ void cmd_c_flags(void) {
     cmd_append(&cmd, "-Wno-initializer-overrides");
 
     cmd_append(&cmd, "-I"THIRDPARTY_FOLDER);
+
+    // Prime_Generator.h uses threads.
+    cmd_append(&cmd, "-pthread");
 }
 
 
@@ -177,6 +180,7 @@ bool build_release(void) {
     cmd_cc();
     cmd_c_flags();
     cmd_append(&cmd, "-O2");
+    // not needed for the prime generator, it picks AVX2 / AVX-512 kernels at runtime.
     // cmd_append(&cmd, "-march=native");
 
     cmd_append(&cmd, "-o", BUILD_FOLDER"main_release");
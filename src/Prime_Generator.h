@@ -6,7 +6,7 @@
 // Author   - Fletcher M
 //
 // Created  - 12/01/26
-// Modified - 15/01/26
+// Modified - 16/10/26
 //
 // Make sure to...
 //      #define PRIME_GENERATOR_IMPLEMENTATION
@@ -33,6 +33,7 @@
 
 #include <stdint.h>     // for 'uint64_t'
 #include <stdbool.h>    // for 'bool'
+#include <stddef.h>     // for 'offsetof'
 
 
 //
@@ -79,6 +80,79 @@
     #define PRIME_GENERATOR_MEM_ZERO(ptr, size) memset((ptr), 0, (size))
 #endif // PRIME_GENERATOR_MEM_ZERO
 
+// counts the 1 bits in a u64, the builtin turns into a single instruction
+// when its available, replace it if your compiler dose not have it.
+#ifndef PRIME_GENERATOR_POPCOUNT
+    #define PRIME_GENERATOR_POPCOUNT(x) ((u64)__builtin_popcountll(x))
+#endif // PRIME_GENERATOR_POPCOUNT
+
+// the index of the lowest 1 bit, x is never 0.
+#ifndef PRIME_GENERATOR_CTZ
+    #define PRIME_GENERATOR_CTZ(x) ((u64)__builtin_ctzll(x))
+#endif // PRIME_GENERATOR_CTZ
+
+// how many 0 bits are above the highest 1 bit, x is never 0.
+#ifndef PRIME_GENERATOR_CLZ
+    #define PRIME_GENERATOR_CLZ(x) ((u64)__builtin_clzll(x))
+#endif // PRIME_GENERATOR_CLZ
+
+//
+// the sieve kernels get compiled a few times, for plain x86-64, AVX2 and AVX-512,
+// and the best one your cpu has is picked when the generator starts, (see 'isa')
+// so the same binary is fast everywhere, no -march=native needed.
+//
+// this needs gcc or clang on x86-64, everything else just gets the plain C kernels,
+// define PRIME_GENERATOR_NO_SIMD if you only want those.
+//
+#if !defined(PRIME_GENERATOR_NO_SIMD) && defined(__x86_64__) && defined(__GNUC__)
+    #define PRIME_GENERATOR_DISPATCH 1
+    #include <immintrin.h>
+#else
+    #define PRIME_GENERATOR_DISPATCH 0
+#endif
+
+// same deal as PRIME_GENERATOR_MEM_ZERO.
+#ifndef PRIME_GENERATOR_MEM_COPY
+    #include <string.h>
+    #define PRIME_GENERATOR_MEM_COPY(dest, src, size) memcpy((dest), (src), (size))
+#endif // PRIME_GENERATOR_MEM_COPY
+
+
+//
+// the generator can sieve blocks on multiple threads, (see 'thread_count')
+//
+// this uses pthreads, if you dont have them, or just dont want them,
+//     #define PRIME_GENERATOR_NO_THREADS
+// and everything runs on the calling thread.
+//
+#ifndef PRIME_GENERATOR_NO_THREADS
+    #include <pthread.h>
+#endif // PRIME_GENERATOR_NO_THREADS
+
+// the shared generator uses these to tell the readers how many primes there are,
+// (see 'Prime_Generator_Shared') anything after a store is seen by whoever loads it.
+#ifndef PRIME_GENERATOR_ATOMIC_LOAD
+    #define PRIME_GENERATOR_ATOMIC_LOAD(ptr)            __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+    #define PRIME_GENERATOR_ATOMIC_STORE(ptr, value)    __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#endif // PRIME_GENERATOR_ATOMIC_LOAD
+
+
+//
+// the generator can save its primes to a file, and map them back in later, (see 'load_prime_generator()')
+//
+// this uses mmap, if you dont have it, or just dont want it,
+//     #define PRIME_GENERATOR_NO_FILES
+// and saving and loading just return false, so the generator makes its primes like normal.
+//
+#ifndef PRIME_GENERATOR_NO_FILES
+    #include <stdio.h>      // for 'fopen' and 'rename'
+    #include <string.h>     // for 'strlen' and 'memcmp'
+    #include <fcntl.h>      // for 'open'
+    #include <unistd.h>     // for 'close'
+    #include <sys/mman.h>   // for 'mmap'
+    #include <sys/stat.h>   // for 'fstat'
+#endif // PRIME_GENERATOR_NO_FILES
+
 
 
 // this is just better, also typedefs dont cause warnings. :)
@@ -104,6 +178,20 @@ struct Prime_Array {
     #endif // USING_BESTED_H
 };
 
+// the same, but 32 bits a prime, for generators using PRIME_GENERATOR_STORAGE_U32.
+typedef struct Prime_Array_U32 Prime_Array_U32;
+
+struct Prime_Array_U32 {
+    #if USING_BESTED_H
+        _Array_Header_;
+        uint32_t *items;
+    #else
+        u64 count;
+        u64 capacity;
+        uint32_t *items;
+    #endif // USING_BESTED_H
+};
+
 
 // using the Sieve of Eratosthenes
 // Wikipedia: https://en.wikipedia.org/wiki/Sieve_of_Eratosthenes
@@ -111,8 +199,8 @@ struct Prime_Array {
 // will append to the array provided, this function cannot be restarted,
 // and is slower then the Prime_Generator.
 //
-// for any significant n, use Prime_Generator, not only because it is faster,
-// but this function uses VLA to allocate n bools on the stack,
+// for any significant n, use Prime_Generator, its faster, and it keeps the primes around,
+// this one only needs a small segment on the stack, and some room for the primes upto sqrt(n).
 void get_primes_upto_number(u64 n, Prime_Array *result);
 
 
@@ -148,6 +236,211 @@ void get_primes_upto_number(u64 n, Prime_Array *result);
 //
 typedef struct Prime_Generator Prime_Generator;
 
+
+// how the generator lays out numbers in its sieve blocks.
+//
+// set this when you construct the generator, it cannot be changed once
+// the generator has started, (clear_prime_generator() keeps it)
+//
+// the wheels cross off about half as many multiples, getting the 10 millionth prime
+// is about 15% faster with them, (storing the primes takes most of the time after that)
+//
+// ```c
+//     Prime_Generator generator = { .layout = PRIME_GENERATOR_LAYOUT_WHEEL_30 };
+// ```
+typedef enum Prime_Generator_Layout {
+    // 1 bit per odd number, the default.
+    PRIME_GENERATOR_LAYOUT_ODD_ONLY = 0,
+    // 1 byte per 30 numbers, multiples of 2, 3 and 5 are never stored.
+    PRIME_GENERATOR_LAYOUT_WHEEL_30,
+    // 48 bits per 210 numbers, multiples of 2, 3, 5 and 7 are never stored.
+    PRIME_GENERATOR_LAYOUT_WHEEL_210,
+
+    PRIME_GENERATOR_LAYOUT_COUNT,
+} Prime_Generator_Layout;
+
+
+// which instruction set the sieve kernels use.
+//
+// leave it as AUTO, and the best one the cpu supports is picked when the generator starts,
+// the others are mostly for testing, if the cpu cant do the one you ask for, you get the
+// best one it can do instead.
+//
+// like the layout, this cannot be changed once the generator has started.
+typedef enum Prime_Generator_Isa {
+    PRIME_GENERATOR_ISA_AUTO = 0,
+    // plain x86-64, or whatever your not x86 cpu is.
+    PRIME_GENERATOR_ISA_BASELINE,
+    // AVX2, BMI2 and popcnt, (Haswell and newer)
+    PRIME_GENERATOR_ISA_AVX2,
+    // AVX-512 F/BW/VL/DQ on top of that, (Skylake-X, Ice Lake, Zen 4)
+    PRIME_GENERATOR_ISA_AVX512,
+
+    PRIME_GENERATOR_ISA_COUNT,
+} Prime_Generator_Isa;
+
+
+// how the generator keeps the primes it has made.
+//
+// like the layout, set it when you construct the generator, (clear_prime_generator() keeps it)
+typedef enum Prime_Generator_Storage {
+    // every prime is a u64 in the generators array, 8 bytes a prime, the default.
+    PRIME_GENERATOR_STORAGE_U64 = 0,
+    // the gaps between the primes, about 1 byte a prime, see 'Prime_Generator_Compressed_Primes'
+    //
+    // the generators array is not used, 'get_nth_prime()' decodes the prime it needs, and the
+    // 'get_all_primes_*()' functions decode into a separate array, that array is reused
+    // so it only lives until the next time you call one of them.
+    PRIME_GENERATOR_STORAGE_COMPRESSED,
+    // primes under 2^32 are kept as u32's, the ones after that go in the generators array,
+    // so the generators 'count' and 'items' are only the primes past 2^32.
+    //
+    // use the '*_u32()' functions to get them without a copy, the normal functions
+    // decode into a separate array, like the compressed storage dose.
+    PRIME_GENERATOR_STORAGE_U32,
+    // the primes from a cache file, mapped in read only, the ones after that go in the generators array,
+    // so the generators 'count' and 'items' are only the primes past the file.
+    //
+    // 'load_prime_generator()' sets this, you dont have to. the 'get_all_primes_*()' functions hand
+    // out the file itself when its u64's and has all the primes you asked for, otherwise they decode like U32.
+    PRIME_GENERATOR_STORAGE_MAPPED,
+    // u64's, but in chunks that never move, each one twice as big as the last, (see 'Prime_Array_Chunked')
+    // so growing never copies anything, and pointers to the primes stay good while the generator keeps going.
+    //
+    // use the '*_chunked()' functions to get them without a copy, the normal functions
+    // decode into a separate array, like the compressed storage dose.
+    PRIME_GENERATOR_STORAGE_CHUNKED,
+
+    PRIME_GENERATOR_STORAGE_COUNT,
+} Prime_Generator_Storage;
+
+// internal, the start of a run of compressed primes.
+typedef struct Prime_Generator_Compressed_Chunk {
+    // the first prime in the chunk, written out in full.
+    u64 base;
+    // where the gaps for the rest of the chunk start.
+    u64 gap_offset;
+} Prime_Generator_Compressed_Chunk;
+
+// internal, primes stored as the gap from the prime before them.
+//
+// the gaps go in 1 byte, or 3 bytes when they are to big, (not until around 4 * 10^11)
+// the primes are split up into chunks of PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE,
+// so chunk 'i' starts at prime number 'i * PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE',
+// and finding a prime only has to decode 1 chunk.
+typedef struct Prime_Generator_Compressed_Primes {
+    Prime_Generator_Compressed_Chunk *chunks;
+    u64 chunk_count;
+    u64 chunk_capacity;
+
+    uint8_t *gaps;
+    u64 gap_count;
+    u64 gap_capacity;
+
+    // how many primes there are, and the last one, so we know the next gap.
+    u64 count;
+    u64 last_prime;
+} Prime_Generator_Compressed_Primes;
+
+// the first chunk of PRIME_GENERATOR_STORAGE_CHUNKED holds this many primes, the next one twice as many, and so on.
+#ifndef PRIME_GENERATOR_FIRST_CHUNK_SIZE
+    #define PRIME_GENERATOR_FIRST_CHUNK_SIZE    (1 << 16)
+#endif // PRIME_GENERATOR_FIRST_CHUNK_SIZE
+
+// doubling 64 times is more than a u64 can count.
+#define PRIME_GENERATOR_MAX_CHUNKS    64
+
+// the primes of a PRIME_GENERATOR_STORAGE_CHUNKED generator.
+//
+// chunk 'k' holds 'PRIME_GENERATOR_FIRST_CHUNK_SIZE << k' primes, starting with prime number
+// 'PRIME_GENERATOR_FIRST_CHUNK_SIZE * (2^k - 1)', (0 indexed) use 'prime_array_chunked_at()'
+// to find one, or go through them a chunk at a time.
+//
+// 'chunks' points into the generator, it dosent move, and neither do the chunks, so this stays
+// good while the generator keeps generating, untill 'clear_prime_generator()'
+typedef struct Prime_Array_Chunked {
+    u64 count;
+    u64 *const *chunks;
+} Prime_Array_Chunked;
+
+// internal, the chunks, see 'Prime_Array_Chunked'
+typedef struct Prime_Generator_Chunked_Primes {
+    u64 *chunks[PRIME_GENERATOR_MAX_CHUNKS];
+    u64 chunk_count;
+    u64 count;
+} Prime_Generator_Chunked_Primes;
+
+// internal, a cache file mapped into memory, see 'load_prime_generator()'
+typedef struct Prime_Generator_Mapped_Primes {
+    // the whole mapping, so we can unmap it.
+    void *base;
+    u64 size;
+
+    // the primes from a 'save_prime_generator()' file, NULL for an indexed one.
+    const u64 *items;
+    // the primes from an 'export_prime_generator()' file, pointing into the mapping.
+    Prime_Generator_Compressed_Primes compressed;
+
+    // how many primes in the file the generator is using, (the file gets cut off at a block)
+    u64 count;
+} Prime_Generator_Mapped_Primes;
+
+// internal lookup tables for a layout, made when the generator starts.
+typedef struct Prime_Generator_Wheel Prime_Generator_Wheel;
+
+
+// internal, a list of primes that will hit a future block.
+typedef struct Prime_Generator_Bucket Prime_Generator_Bucket;
+
+// internal, the bucket sieve.
+//
+// primes bigger than a whole block hit a block at most once, so instead of
+// checking every one of them on every block, each prime waits in the bucket
+// of the next block it hits.
+typedef struct Prime_Generator_Bucket_Sieve {
+    // one list of buckets for each upcoming block, indexed with 'block_number & (ring_size-1)'
+    Prime_Generator_Bucket **ring;
+    // always a power of 2.
+    u64 ring_size;
+
+    // the block we are about to sieve.
+    u64 block_number;
+
+    // empty buckets we can reuse.
+    Prime_Generator_Bucket *free_buckets;
+} Prime_Generator_Bucket_Sieve;
+
+
+// internal, a prime we sieve with, and where its next multiple is.
+typedef struct Prime_Generator_Sieving_Prime Prime_Generator_Sieving_Prime;
+
+// internal, a thread that sieves blocks for the generator.
+typedef struct Prime_Generator_Worker Prime_Generator_Worker;
+
+// internal, a run of blocks that one worker sieves.
+typedef struct Prime_Generator_Task Prime_Generator_Task;
+
+// internal, everything needed to sieve one block after another.
+//
+// every prime remembers where its next multiple is, so going
+// to the next block is just adding and comparing, no dividing.
+typedef struct Prime_Generator_Sieve {
+    // the start of the next block to sieve.
+    u64 block_start;
+
+    // index of the next prime to start sieving with, 0 if we haven't started.
+    u64 next_prime_index;
+
+    // primes smaller than a block, they hit (almost) every block.
+    Prime_Generator_Sieving_Prime *sieving_primes;
+    u64 sieving_prime_count;
+    u64 sieving_prime_capacity;
+
+    // primes bigger than a block.
+    Prime_Generator_Bucket_Sieve bucket_sieve;
+} Prime_Generator_Sieve;
+
+
 struct Prime_Generator {
 
     // the inner array, made this way so its easy to assign an allocator
@@ -178,15 +471,111 @@ struct Prime_Generator {
 
     // used when generating the next block.
     u64 last_prime_checked;
+
+    // the layout of the sieve blocks, see 'Prime_Generator_Layout'
+    Prime_Generator_Layout layout;
+    // the instruction set to sieve with, see 'Prime_Generator_Isa'
+    Prime_Generator_Isa isa;
+    // how the primes are kept, see 'Prime_Generator_Storage'
+    Prime_Generator_Storage storage;
+    // made from 'layout' on the first block, NULL until then.
+    Prime_Generator_Wheel *wheel;
+
+    // the sieving primes, and where they are up to.
+    Prime_Generator_Sieve sieve;
+
+    // only used with PRIME_GENERATOR_STORAGE_COMPRESSED.
+    Prime_Generator_Compressed_Primes compressed;
+    // only used with PRIME_GENERATOR_STORAGE_U32, the primes under 2^32.
+    Prime_Array_U32 u32_primes;
+    // only used with PRIME_GENERATOR_STORAGE_MAPPED, the primes from the cache file.
+    Prime_Generator_Mapped_Primes mapped;
+    // only used with PRIME_GENERATOR_STORAGE_CHUNKED.
+    Prime_Generator_Chunked_Primes chunked;
+
+    // for everything thats not PRIME_GENERATOR_STORAGE_U64,
+    //
+    // the new primes go here before they get stored.
+    Prime_Array staging;
+
+    // the primes we sieve with, every prime under 'sieving_prime_limit'
+    //
+    // these are kept away from the primes we hand out, so the generator never has to read
+    // those back, (they can be compressed, or thrown away) it makes more of these as it needs them.
+    Prime_Array sieving_prime_table;
+    u64 sieving_prime_limit;
+
+    // what the 'get_all_primes_*()' functions hand out.
+    Prime_Array view;
+
+    // keep the sieve bits of every number weve checked, so 'is_prime()' is just looking up a bit,
+    // costs 1 bit per odd number, (less with the wheels) so 64MB for the numbers under 10^9.
+    //
+    // set it when you construct the generator, kept by 'clear_prime_generator()', like the layout.
+    bool keep_bitmap;
+    // internal, the bits, (not a list of primes) bit 'i' is set if the number
+    // '(i / R) * modulus + residues[i % R]' is a prime, (R and modulus come from the layout)
+    Prime_Array bitmap;
+
+    // how many threads to generate with, 0 or 1 means just the calling thread.
+    //
+    // kept by 'clear_prime_generator()', like the layout.
+    u64 thread_count;
+    // internal, one for each thread, kept around so we dont reallocate every time.
+    Prime_Generator_Worker *workers;
+    u64 worker_count;
+    Prime_Generator_Task *tasks;
+    u64 task_capacity;
 };
 
 
 // only for bested.h for allocator alignment reasons
 #if USING_BESTED_H
-    PRIME_GENERATOR_STATIC_ASSERT(sizeof(Prime_Array) == sizeof(Prime_Generator) - sizeof(u64), "check if the union is doing the right thing.");
+    PRIME_GENERATOR_STATIC_ASSERT(offsetof(Prime_Generator, last_prime_checked) == sizeof(Prime_Array), "check if the union is doing the right thing.");
 #endif // USING_BESTED_H
 
 
+//
+// a generator that lots of threads can use at once, without each of them having its own.
+//
+// the array is made big enough for every prime upto 'max_n' when you init it, so it never moves,
+// and reading primes the generator allready has dosent take a lock, (just an atomic load)
+// when a thread needs more, it takes a lock, generates them, and then publishes the new count.
+//
+// ```c
+//     // the settings go on the generator inside it. (only PRIME_GENERATOR_STORAGE_U64)
+//     Prime_Generator_Shared shared = { .generator = { .thread_count = 8 } };
+//     init_shared_prime_generator(&shared, 10000000000);
+//
+//     // from any thread.
+//     u64 prime = get_nth_prime_shared(&shared, 420);
+//
+//     // once all the threads are done with it.
+//     clear_shared_prime_generator(&shared);
+// ```
+//
+typedef struct Prime_Generator_Shared {
+    // the generator doing the work, only touch it before 'init_shared_prime_generator()'
+    Prime_Generator generator;
+
+    // internal, the generators array, it never moves, so the readers can just read it.
+    const u64 *primes;
+    // internal, the biggest number it can go upto, the array is big enough for the primes under it.
+    u64 max_n;
+
+    // internal, the readers can use this many primes, every prime under 'published_upto' is in there.
+    //
+    // they only ever grow, and are only used with PRIME_GENERATOR_ATOMIC_LOAD / PRIME_GENERATOR_ATOMIC_STORE.
+    u64 published_count;
+    u64 published_upto;
+
+    #ifndef PRIME_GENERATOR_NO_THREADS
+        // internal, only one thread makes more primes at a time.
+        pthread_mutex_t extend_lock;
+    #endif // PRIME_GENERATOR_NO_THREADS
+} Prime_Generator_Shared;
+
+
 
 /////////////////////////////////////////////////
 //         PRIME GENERATOR INTERFACE
@@ -219,6 +608,159 @@ Prime_Array get_all_primes_upto_nth_prime(Prime_Generator *prime_generator, u64
 Prime_Array get_all_primes_under_n(Prime_Generator *prime_generator, u64 n);
 
 
+// is 'n' a prime, never generates anything.
+//
+// numbers the generator has allready checked are looked up, (a single bit with 'keep_bitmap',
+// a binary search through the primes without it) anything bigger gets a deterministic
+// primality test, so its always right, just not as fast.
+bool is_prime(Prime_Generator *prime_generator, u64 n);
+
+// is 'n' a prime, without a generator, deterministic Miller-Rabin, right for every u64.
+//
+// 'is_prime()' uses this past what the generator has, its well under a microsecond.
+bool is_prime_no_generator(u64 n);
+
+// the smallest prime >= x, and the biggest prime <= x, neither one generates anything.
+//
+// if the generator allready has it, its looked up, otherwise we just try numbers
+// with 'is_prime_no_generator()' untill one is prime, the gaps are only about ln(x)
+// so this takes a few microseconds, no matter how big x is.
+//
+// there is no prime bigger than 18446744073709551557 that fits in a u64, or smaller than 2,
+// so those return 0.
+u64 next_prime(Prime_Generator *prime_generator, u64 x);
+u64 prev_prime(Prime_Generator *prime_generator, u64 x);
+
+// how many primes are under n, without making them all.
+//
+// if the generator allready has them, they are just counted, otherwise this uses
+// the Meissel-Lehmer method, and only needs the primes upto sqrt(n),
+// so pi(10^14) takes seconds, and a few megabytes.
+u64 count_primes_under_n(Prime_Generator *prime_generator, u64 n);
+
+// 1 indexed, the same answer as 'get_nth_prime()', but without keeping all the primes before it.
+//
+// estimates where the nth prime is, counts the primes upto just before there,
+// (see 'count_primes_under_n()') and sieves forward untill it finds it,
+// so it only needs the primes upto sqrt(p_n), 'get_nth_prime(10^8)' keeps 800MB of primes, this dosent.
+//
+// if the generator allready has the nth prime, its just handed back.
+u64 find_nth_prime(Prime_Generator *prime_generator, u64 n);
+
+// appends the primes in [lo, hi) to 'result', without generating everything under lo.
+//
+// only the primes upto sqrt(hi) get made, (to sieve with) then just the blocks with [lo, hi)
+// in them get sieved, (the parts the generator allready has are copied out of it)
+void get_primes_in_range(Prime_Generator *prime_generator, u64 lo, u64 hi, Prime_Array *result);
+
+// gets handed the primes a block at a time, in order, return false to stop early.
+//
+// 'primes' is only good untill you return, its reused for the next block,
+// and dont use the generator from inside the callback, its in the middle of something.
+typedef bool (*Prime_Generator_Callback)(const u64 *primes, u64 count, void *user_data);
+
+// calls 'callback' with every prime in [lo, hi), without keeping them.
+//
+// only the primes upto sqrt(hi) are kept, (to sieve with) so going over everything
+// upto 10^12 takes a few MB, instead of the 300GB 'get_all_primes_under_n()' would need.
+//
+// ```c
+//     bool sum_primes(const u64 *primes, u64 count, void *user_data) {
+//         u64 *sum = user_data;
+//         for (u64 i = 0; i < count; i++) *sum += primes[i];
+//         return true;
+//     }
+//
+//     u64 sum = 0;
+//     for_each_prime_in_range(&generator, 0, 1000000000, sum_primes, &sum);
+// ```
+void for_each_prime_in_range(Prime_Generator *prime_generator, u64 lo, u64 hi, Prime_Generator_Callback callback, void *user_data);
+
+
+// the same as the functions above, but without a copy, for generators using PRIME_GENERATOR_STORAGE_U32.
+//
+// the primes have to fit in 32 bits, so 'n' cant be more than 203280221 (the number of primes under 2^32)
+// for 'get_all_primes_upto_nth_prime_u32()', or more than 2^32 for 'get_all_primes_under_n_u32()'
+//
+// same *WARNING* as above.
+Prime_Array_U32 get_all_primes_upto_nth_prime_u32(Prime_Generator *prime_generator, u64 n);
+Prime_Array_U32 get_all_primes_under_n_u32(Prime_Generator *prime_generator, u64 n);
+
+// the same as the functions above, but without a copy, for generators using PRIME_GENERATOR_STORAGE_CHUNKED.
+//
+// unlike the others, these stay good when the generator makes more primes. (see 'Prime_Array_Chunked')
+//
+// ```c
+//     Prime_Generator generator = { .storage = PRIME_GENERATOR_STORAGE_CHUNKED };
+//     Prime_Array_Chunked primes = get_all_primes_under_n_chunked(&generator, 1000000);
+//
+//     const u64 *first = prime_array_chunked_at(primes, 0);
+//     get_nth_prime(&generator, 100000000); // 'primes' and 'first' are still fine.
+// ```
+Prime_Array_Chunked get_all_primes_upto_nth_prime_chunked(Prime_Generator *prime_generator, u64 n);
+Prime_Array_Chunked get_all_primes_under_n_chunked(Prime_Generator *prime_generator, u64 n);
+// where the prime at 'index' (0 indexed) is, it has to be under 'array.count'
+const u64 *prime_array_chunked_at(Prime_Array_Chunked array, u64 index);
+
+
+// write every prime the generator has to a cache file at 'path', returns false if it couldnt.
+//
+// its a small header, (see 'Prime_Generator_Cache_Header') then the primes as u64's,
+// its written next to 'path' and then renamed over it, so anyone who has the old file
+// mapped keeps the old file, instead of getting half of the new one.
+bool save_prime_generator(Prime_Generator *prime_generator, const char *path);
+
+// start a generator from a cache file made by 'save_prime_generator()', returns false if it couldnt.
+//
+// the file is mapped in read only, not read, so this takes microseconds no matter how big it is,
+// and every process that loads the same file shares the same memory, (its just the page cache)
+// anything past the file gets generated like normal.
+//
+// the generator has to be fresh, (or cleared) and use PRIME_GENERATOR_STORAGE_U64, it switches
+// to PRIME_GENERATOR_STORAGE_MAPPED, (and back, when you clear it) any layout works, if the
+// file isnt there, or is broken, the generator is left alone and just generates like normal.
+//
+// ```c
+//     Prime_Generator generator = {};
+//     if (!load_prime_generator(&generator, "primes.cache")) {
+//         generate_primes_until_nth_prime(&generator, 100000000);
+//         save_prime_generator(&generator, "primes.cache");
+//     }
+// ```
+//
+// it loads 'export_prime_generator()' files too, those stay compressed, so 'get_nth_prime()' and
+// 'is_prime()' only decode the one chunk they need, and only that part of the file is read off the disk.
+//
+// the 'get_all_primes_*()' arrays can point right into the file, so writing to them will crash.
+bool load_prime_generator(Prime_Generator *prime_generator, const char *path);
+
+// write every prime under n to an indexed cache file at 'path', returns false if it couldnt.
+//
+// the primes are the gaps between them, about 1 byte a prime, (like PRIME_GENERATOR_STORAGE_COMPRESSED)
+// with a checkpoint every PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE primes, (see 'Prime_Generator_Index_Header')
+//
+// the primes are streamed out with 'for_each_prime_in_range()', so the generator dosent keep them,
+// and the file can be way bigger than your memory, 'load_prime_generator()' maps it back in.
+bool export_prime_generator(Prime_Generator *prime_generator, u64 n, const char *path);
+
+
+// get a 'Prime_Generator_Shared' ready, it can go upto 'max_n', returns false if it couldnt.
+//
+// the room for the primes is only reserved, not touched, so a big 'max_n' only costs address space,
+// (on linux anyway, and about 8 bytes for every prime under it, so 10^12 is 300GB of it)
+bool init_shared_prime_generator(Prime_Generator_Shared *shared, u64 max_n);
+// free's everything, none of the threads can be using it, keeps the generators settings.
+void clear_shared_prime_generator(Prime_Generator_Shared *shared);
+
+// the same as the normal functions, but any thread can call them at the same time.
+//
+// the arrays never move, so they stay good untill 'clear_shared_prime_generator()',
+// asking for something past 'max_n' asserts, and gets 0 / an empty array.
+u64 get_nth_prime_shared(Prime_Generator_Shared *shared, u64 n);
+Prime_Array get_all_primes_upto_nth_prime_shared(Prime_Generator_Shared *shared, u64 n);
+Prime_Array get_all_primes_under_n_shared(Prime_Generator_Shared *shared, u64 n);
+
+
 // marks a functions as belonging to this header file only.
 #define Prime_Generator_Internal     static
 
@@ -236,95 +778,105 @@ Prime_Array get_all_primes_under_n(Prime_Generator *prime_generator, u64 n);
 #define PRIME_GENERATOR_IMPLEMENTATION_GUARD_
 
 
-Prime_Generator_Internal void Prime_Array_Append(Prime_Array *array, u64 n) {
+// make sure the array can hold 'n' primes, dose not change count.
+//
+// grows to at least double, so calling this with a little more every time is still fine.
+Prime_Generator_Internal bool Prime_Array_Reserve(Prime_Array *array, u64 n) {
+    if (!array) {
+        PRIME_GENERATOR_ASSERT(array && "Tried to reserve a NULL pointer...");
+        return false;
+    }
+    if (n <= array->capacity) return true;
+
+    #if USING_BESTED_H
+        Array_Reserve(array, n);
+    #else
+        u64 new_capacity = array->capacity * 2;
+        if (new_capacity < n) new_capacity = n;
+
+        u64 *new_items = PRIME_GENERATOR_REALLOC(array->items, array->capacity*sizeof(array->items[0]), new_capacity*sizeof(array->items[0]));
+        if (!new_items) {
+            PRIME_GENERATOR_ASSERT(new_items && "You ran out of memory, how many primes did you just try to make?");
+            return false;
+        }
+        array->items    = new_items;
+        array->capacity = new_capacity;
+    #endif // USING_BESTED_H
+
+    return true;
+}
+
+// add a whole bunch of primes at once.
+Prime_Generator_Internal void Prime_Array_Append_Many(Prime_Array *array, const u64 *items, u64 count) {
     if (!array) {
         PRIME_GENERATOR_ASSERT(array && "Tried to append to NULL pointer...");
         return;
     }
+    if (count == 0) return;
 
     #if USING_BESTED_H
-        // just use Bested.h's one.
-        Array_Append(array, n);
+        u64 *dest = Array_Add(array, count);
     #else
-        if (array->count >= array->capacity) {
+        if (array->count + count > array->capacity) {
             // manually allocate
-            u64 new_capacity = array->capacity != 0 ? array->capacity * 2 : 32; // double or otherwise 32
-            array->items = PRIME_GENERATOR_REALLOC(array->items, array->capacity*sizeof(array->items[0]), new_capacity*sizeof(array->items[0]));
-            if (!array->items) {
-                PRIME_GENERATOR_ASSERT(array->items && "You ran out of memory, how many primes did you just try to make?");
+            u64 new_capacity = array->capacity != 0 ? array->capacity : 32;
+            while (new_capacity < array->count + count) new_capacity *= 2;
+
+            u64 *new_items = PRIME_GENERATOR_REALLOC(array->items, array->capacity*sizeof(array->items[0]), new_capacity*sizeof(array->items[0]));
+            if (!new_items) {
+                PRIME_GENERATOR_ASSERT(new_items && "You ran out of memory, how many primes did you just try to make?");
                 return;
             }
+            array->items    = new_items;
             array->capacity = new_capacity;
         }
-        array->items[array->count++] = n;
+        u64 *dest = &array->items[array->count];
+        array->count += count;
     #endif // USING_BESTED_H
-}
-
-
-
-// using the Sieve of Eratosthenes
-// Wikipedia: https://en.wikipedia.org/wiki/Sieve_of_Eratosthenes
-//
-// will append to the array provided, this function cannot be restarted,
-// and is slower then the Prime_Generator.
-//
-// for any significant n, use Prime_Generator, not only because it is faster,
-// but this function uses VLA to allocate n bools on the stack,
-void get_primes_upto_number(u64 n, Prime_Array *result) {
-    if (!result) {
-        PRIME_GENERATOR_ASSERT(result && "must pass in a valid result array, got NULL");
-        return;
-    }
-    if (n < 2) { return; }
 
+    PRIME_GENERATOR_MEM_COPY(dest, items, count * sizeof(items[0]));
+}
 
-    // TODO this will fail with bigger n, it will run out of stack space
-    //
-    // TODO make this not have +1,
-    bool is_not_prime_array[n+1];
-    PRIME_GENERATOR_MEM_ZERO(is_not_prime_array, sizeof(is_not_prime_array));
+// free's an array that was grown with the functions above, (and has no allocator)
+Prime_Generator_Internal void Prime_Array_Free(Prime_Array *array) {
+    #if USING_BESTED_H
+        Array_Free(array);
+    #else
+        PRIME_GENERATOR_FREE(array->items, array->capacity * sizeof(array->items[0]));
+    #endif // USING_BESTED_H
+    PRIME_GENERATOR_MEM_ZERO(array, sizeof(*array));
+}
 
-    // these are not prime.
-    is_not_prime_array[0] = true;
-    is_not_prime_array[1] = true;
+// the same as 'Prime_Array_Reserve()'
+Prime_Generator_Internal bool Prime_Array_U32_Reserve(Prime_Array_U32 *array, u64 n) {
+    if (n <= array->capacity) return true;
 
-    // special case 2
-    for (size_t i = 2*2; i <= n; i += 2) is_not_prime_array[i] = true;
+    #if USING_BESTED_H
+        Array_Reserve(array, n);
+    #else
+        u64 new_capacity = array->capacity * 2;
+        if (new_capacity < n) new_capacity = n;
 
-    u64 current_prime = 3;
-    while (true) {
-        // look for next prime
-        for (; current_prime <= n; current_prime++) {
-            // if the number is still false, its a prime
-            if (!is_not_prime_array[current_prime]) { break; }
+        uint32_t *new_items = PRIME_GENERATOR_REALLOC(array->items, array->capacity*sizeof(array->items[0]), new_capacity*sizeof(array->items[0]));
+        if (!new_items) {
+            PRIME_GENERATOR_ASSERT(new_items && "You ran out of memory, how many primes did you just try to make?");
+            return false;
         }
-        if (current_prime > n) break;
-
-        // set everything thats a multiple of this number to 'not a prime'
-        //
-        // go 2 at a time because even numbers are allready done.
-        for (u64 i = current_prime*3; i <= n; i += current_prime*2) { is_not_prime_array[i] = true; }
-
-        // repeat process, look for next prime
-        current_prime += 1;
-    }
-
-    // TODO we could use this to perfectly allocate a buffer.
-    // u64 prime_count = 0;
-    // for (size_t i = 0; i <= n; i++) {
-    //     if (!is_not_prime_array[i]) prime_count += 1;
-    // }
-
-    for (size_t i = 0; i <= n; i++) {
-        if (is_not_prime_array[i]) continue;
+        array->items    = new_items;
+        array->capacity = new_capacity;
+    #endif // USING_BESTED_H
 
-        Prime_Array_Append(result, i);
-    }
-    // this assert just naturally falls off.
-    PRIME_GENERATOR_ASSERT(result->items[0] == 2);
+    return true;
 }
 
-
+Prime_Generator_Internal void Prime_Array_U32_Free(Prime_Array_U32 *array) {
+    #if USING_BESTED_H
+        Array_Free(array);
+    #else
+        PRIME_GENERATOR_FREE(array->items, array->capacity * sizeof(array->items[0]));
+    #endif // USING_BESTED_H
+    PRIME_GENERATOR_MEM_ZERO(array, sizeof(*array));
+}
 
 
 // https://en.wikipedia.org/wiki/Integer_square_root
@@ -343,101 +895,2484 @@ Prime_Generator_Internal u64 int_sqrt(u64 n) {
     return R;
 }
 
+// the biggest r where r*r*r <= n
+Prime_Generator_Internal u64 int_cbrt(u64 n) {
+    // cbrt(2^64) is a little over this, so the cube never overflows.
+    u64 low = 0, high = 2642245;
+    while (low < high) {
+        u64 mid = (low + high + 1) / 2;
+        if (mid * mid * mid <= n) low  = mid;
+        else                      high = mid - 1;
+    }
+    return low;
+}
 
-// private function, generates the next block of primes.
+
+// https://en.wikipedia.org/wiki/Natural_logarithm
 //
-// returns the number of added primes, maybe that will be useful someday.
-Prime_Generator_Internal u64 __generate_prime_block(Prime_Generator *prime_generator) {
-    // did a couple of bench tests, bigger number is better here.
-    //
-    // will make the inital get_primes_upto_number() slower,
-    // but that takes < 1ms, so ehh.
-    #define PRIME_GENERATOR_BLOCK_SIZE    (1 << 16)
+// so we dont need libm, good to about 15 digits, witch is more than we need.
+Prime_Generator_Internal double __prime_generator_ln(double x) {
+    if (x <= 0) return 0;
 
-    if (prime_generator->last_prime_checked % PRIME_GENERATOR_BLOCK_SIZE != 0) {
-        PRIME_GENERATOR_ASSERT(prime_generator->last_prime_checked % PRIME_GENERATOR_BLOCK_SIZE == 0 && "dont mess with my innards, last_prime_checked was not a multiple of PRIME_GENERATOR_BLOCK_SIZE");
-        return 0;
-    }
+    // x = m * 2^e, with m in [1, 2)
+    int e = 0;
+    while (x >= 2)  { x /= 2; e += 1; }
+    while (x <  1)  { x *= 2; e -= 1; }
 
-    if (prime_generator->last_prime_checked >= (1UL << 60)) {
-        PRIME_GENERATOR_ASSERT(false && "This is getting a little out of hand.");
-        return 0;
+    // ln(m) = 2 * atanh((m-1)/(m+1)), and (m-1)/(m+1) <= 1/3 so this goes fast.
+    double z  = (x - 1) / (x + 1);
+    double z2 = z * z;
+    double term = z, sum = 0;
+    for (int k = 1; k < 60; k += 2) {
+        sum  += term / k;
+        term *= z2;
     }
 
-    if (prime_generator->last_prime_checked == 0) {
-        // we special case 0, because it has 2 as the first prime,
-        // and we can do some optimizations knowing we have 2.
-        //
-        // also knowing all numbers in the block cannot effect the block itself is good.
-        // 
-        // so we just use a simple Sieve, im a little
-        // worried this might be slow if we crank the block size
-        get_primes_upto_number(PRIME_GENERATOR_BLOCK_SIZE, &prime_generator->inner_prime_array);
-        prime_generator->last_prime_checked = PRIME_GENERATOR_BLOCK_SIZE;
-        return prime_generator->inner_prime_array.count;
-    }
+    return 2 * sum + e * 0.69314718055994530942;
+}
 
-    // we *know* that we have 2 so lets do a little optimization.
-    if (prime_generator->inner_prime_array.items[0] != 2) {
-        PRIME_GENERATOR_ASSERT(prime_generator->inner_prime_array.items[0] == 2);
-        return 0;
-    }
+// a number bigger than the nth prime,
+// https://en.wikipedia.org/wiki/Prime_number_theorem#Approximations_for_the_nth_prime_number
+Prime_Generator_Internal u64 __nth_prime_upper_bound(u64 n) {
+    if (n < 6) return 13;
+    double ln_n = __prime_generator_ln((double) n);
+    return (u64)((double) n * (ln_n + __prime_generator_ln(ln_n))) + 1;
+}
 
+// a number bigger than the number of primes under x,
+// https://en.wikipedia.org/wiki/Prime-counting_function#Inequalities
+Prime_Generator_Internal u64 __prime_count_upper_bound(u64 x) {
+    // the bound below only works for big enough x.
+    if (x < 355991) return x / 2 + 2;
+    double ln_x = __prime_generator_ln((double) x);
+    return (u64)((double) x / ln_x * (1 + 1/ln_x + 2.51/(ln_x*ln_x))) + 1;
+}
 
-    // remove all even cells with /2, by definition.
-    bool is_not_prime_array[PRIME_GENERATOR_BLOCK_SIZE/2];
-    PRIME_GENERATOR_MEM_ZERO(is_not_prime_array, sizeof(is_not_prime_array));
-    // Mem_Zero(is_not_prime_array, sizeof(is_not_prime_array));
+// the logarithmic integral, li(x) is really close to pi(x), (a little bigger)
+// https://en.wikipedia.org/wiki/Logarithmic_integral_function#Series_representation
+//
+// this is Ramanujan's series, it goes fast, x has to be bigger than 1.
+Prime_Generator_Internal double __prime_generator_li(double x) {
+    const double euler_gamma = 0.57721566490153286061;
+    double ln_x = __prime_generator_ln(x);
 
-    // do the primes we have
-    u64 sqrt_of_ending = int_sqrt(prime_generator->last_prime_checked + PRIME_GENERATOR_BLOCK_SIZE);
-    // start from 1, we remove all even cells, so we dont need 2
-    for (size_t i = 1; i < prime_generator->inner_prime_array.count; i++) {
-        u64 prime = prime_generator->inner_prime_array.items[i];
-        if (prime > sqrt_of_ending) break;
+    // sqrt without libm, int_sqrt gets us close, and one Newton step fixes the fraction.
+    double sqrt_x = (double) int_sqrt((u64) x);
+    sqrt_x = (sqrt_x + x / sqrt_x) / 2;
 
-        // do a bunch of math to figure of what position we start at in the array
-        u64 div_ceil = (prime_generator->last_prime_checked + prime - 1) / prime;
-        u64 normal_start = div_ceil * prime;
-        u64 regular_array_start = normal_start - prime_generator->last_prime_checked;
-        // make sure its not even, we removed all of those cells.
-        if (regular_array_start % 2 == 0) { regular_array_start += prime; }
-        u64 start = regular_array_start / 2;
+    // term is (-1)^(n-1) * ln(x)^n / (n! * 2^(n-1)), and inner_sum is 1 + 1/3 + 1/5 ... upto 1/n
+    double sum = 0, term = 1, inner_sum = 0;
+    for (int n = 1; n < 200; n++) {
+        term *= (n == 1) ? ln_x : -ln_x / (2 * n);
+        if (n % 2) inner_sum += 1.0 / n;
 
-        // technically were iterating by 'prime * 2 / 2'
-        //     / 2 because we removed the even cells
-        //     * 2 because all multiples of 2 are gone. and we dont need to check them.
-        for (u64 j = start; j < PRIME_GENERATOR_BLOCK_SIZE/2; j += prime) {
-            is_not_prime_array[j] = true;
-        }
+        sum += term * inner_sum;
+        if (n > ln_x && (term < 0 ? -term : term) < 1e-18) break;
     }
 
-    // none of the numbers in this block can effect each other,
-    // (because we did a first block, and any numbers in here
-    // are bigger than PRIME_GENERATOR_BLOCK_SIZE)
-    u64 number_of_primes_this_round = 0;
-    for (size_t i = 0; i < PRIME_GENERATOR_BLOCK_SIZE/2; i++) {
-        if (is_not_prime_array[i]) continue;
-        // i*2+1 to account for the array.
-        u64 new_prime = prime_generator->last_prime_checked + (i*2+1);
-        // add it to the list
-        Prime_Array_Append(&prime_generator->inner_prime_array, new_prime);
+    return euler_gamma + __prime_generator_ln(ln_x) + sqrt_x * sum;
+}
 
-        number_of_primes_this_round += 1;
-    }
+// roughly where the nth prime is, solves li(x) = n with Newtons method, (li'(x) = 1 / ln(x))
+//
+// li(x) is a little bigger than pi(x), so this is normally a little under the real one.
+Prime_Generator_Internal u64 __nth_prime_estimate(u64 n) {
+    if (n < 6) return 2;
 
-    prime_generator->last_prime_checked += PRIME_GENERATOR_BLOCK_SIZE;
-    return number_of_primes_this_round;
+    double x = (double) n * __prime_generator_ln((double) n);
+    for (int i = 0; i < 100; i++) {
+        double step = (__prime_generator_li(x) - (double) n) * __prime_generator_ln(x);
+        x -= step;
+        if (step < 1 && step > -1) break;
+    }
+    return (u64) x;
 }
 
 
+// numbers are sieved this many bytes at a time in 'get_primes_upto_number()',
+// the segment lives on the stack, so dont make it huge, 32KB fits in L1.
+#ifndef PRIME_GENERATOR_SEGMENT_SIZE
+    #define PRIME_GENERATOR_SEGMENT_SIZE    (1 << 15)
+#endif // PRIME_GENERATOR_SEGMENT_SIZE
 
+#define PRIME_GENERATOR_SEGMENT_WORDS    (PRIME_GENERATOR_SEGMENT_SIZE / 8)
 
 
-void clear_prime_generator(Prime_Generator *prime_generator) {
-    // this will always exist, and we will always preseve it.
-    void *allocator = prime_generator->allocator;
-
+// using the Sieve of Eratosthenes
+// Wikipedia: https://en.wikipedia.org/wiki/Sieve_of_Eratosthenes
+//
+// will append to the array provided, this function cannot be restarted,
+// and is slower then the Prime_Generator.
+//
+// this is a segmented sieve, 1 bit per odd number, so it only needs one
+// segment on the stack, plus where the next multiple of every prime upto
+// sqrt(n) is, (about 1MB at n = 10^12, the primes themselves are way bigger)
+//
+// the result is grown once, from an upper bound of the prime count.
+void get_primes_upto_number(u64 n, Prime_Array *result) {
+    if (!result) {
+        PRIME_GENERATOR_ASSERT(result && "must pass in a valid result array, got NULL");
+        return;
+    }
+    if (n < 2) { return; }
+
+
+    // the extraction writes a few past the last prime, so leave a little room.
+    u64 max_prime_count = __prime_count_upper_bound(n);
+    if (!Prime_Array_Reserve(result, result->count + max_prime_count + 8)) return;
+
+    u64 *out     = &result->items[result->count];
+    u64 *out_end = out + max_prime_count;
+
+    // special case 2, the only even prime.
+    *out++ = 2;
+
+
+    // the primes we cross off with, the ones upto sqrt(n).
+    //
+    // 'next' is the bit of the next odd multiple we have not crossed off yet,
+    // (bit i is the number 2*i + 1)
+    typedef struct { u64 prime; u64 next; } Sieving_Prime;
+
+    u64 sqrt_n = int_sqrt(n);
+    u64 sieving_prime_capacity = __prime_count_upper_bound(sqrt_n);
+    u64 sieving_prime_count    = 0;
+
+    Sieving_Prime *sieving_primes = PRIME_GENERATOR_REALLOC(NULL, 0, sieving_prime_capacity * sizeof(Sieving_Prime));
+    if (!sieving_primes) {
+        PRIME_GENERATOR_ASSERT(sieving_primes && "You ran out of memory, how?");
+        return;
+    }
+
+
+    u64 is_not_prime_bits[PRIME_GENERATOR_SEGMENT_WORDS];
+    const u64 bits_per_segment = PRIME_GENERATOR_SEGMENT_WORDS * 64;
+
+    // one bit for every odd number upto n.
+    const u64 total_bits = (n - 1) / 2 + 1;
+
+    for (u64 low = 0; low < total_bits; low += bits_per_segment) {
+        u64 high = (total_bits - low < bits_per_segment) ? total_bits : low + bits_per_segment;
+        u64 bit_count  = high - low;
+        u64 word_count = (bit_count + 63) / 64;
+
+        PRIME_GENERATOR_MEM_ZERO(is_not_prime_bits, word_count * sizeof(u64));
+        // the bits past n are not primes.
+        if (bit_count % 64) is_not_prime_bits[word_count-1] = ~0ULL << (bit_count % 64);
+        // 1 is not a prime.
+        if (low == 0) is_not_prime_bits[0] |= 1;
+
+        for (u64 i = 0; i < sieving_prime_count; i++) {
+            u64 prime = sieving_primes[i].prime;
+            u64 j     = sieving_primes[i].next;
+
+            // technically were iterating by 'prime * 2 / 2'
+            //     / 2 because we removed the even cells
+            //     * 2 because all multiples of 2 are gone. and we dont need to check them.
+            for (; j < high; j += prime) {
+                u64 bit = j - low;
+                is_not_prime_bits[bit / 64] |= 1ULL << (bit % 64);
+            }
+            sieving_primes[i].next = j;
+        }
+
+        // new sieving primes, any segment that starts below sqrt(n) can have some,
+        // (past n = 2^38 or so thats more than just the first one) and they have
+        // multiples in the same segment, so look for them in order, like the plain sieve.
+        for (u64 bit = 0; bit < bit_count; bit++) {
+            u64 number = (low + bit) * 2 + 1;
+            if (number > sqrt_n) break;
+            if (is_not_prime_bits[bit / 64] & (1ULL << (bit % 64))) continue;
+
+            // start at prime*prime, everything smaller has a smaller factor.
+            u64 j = number * number / 2;
+            for (; j < high; j += number) {
+                u64 b = j - low;
+                is_not_prime_bits[b / 64] |= 1ULL << (b % 64);
+            }
+            sieving_primes[sieving_prime_count++] = (Sieving_Prime){ .prime = number, .next = j };
+        }
+
+
+        // pull the primes out, count trailing zeros jumps straight to them.
+        u64 number_start = low * 2 + 1;
+        for (u64 i = 0; i < word_count; i++) {
+            u64 primes = ~is_not_prime_bits[i];
+            u64 count  = PRIME_GENERATOR_POPCOUNT(primes);
+
+            if (out + count > out_end) {
+                PRIME_GENERATOR_ASSERT(out + count <= out_end && "more primes than the upper bound said, this is a bug.");
+                PRIME_GENERATOR_FREE(sieving_primes, sieving_prime_capacity * sizeof(Sieving_Prime));
+                return;
+            }
+
+            // always do 4, the reserve left room for it, the top bit keeps ctz away from 0.
+            for (u64 k = 0; k < 4; k++) {
+                out[k] = number_start + 2 * PRIME_GENERATOR_CTZ(primes | (1ULL << 63));
+                primes &= primes - 1;
+            }
+            for (u64 k = 4; k < count; k++) {
+                out[k] = number_start + 2 * PRIME_GENERATOR_CTZ(primes);
+                primes &= primes - 1;
+            }
+
+            out += count;
+            number_start += 128;
+        }
+    }
+
+    PRIME_GENERATOR_FREE(sieving_primes, sieving_prime_capacity * sizeof(Sieving_Prime));
+
+    result->count = out - result->items;
+}
+
+
+
+
+
+
+
+// did a couple of bench tests, bigger number is better here.
+//
+// this is the size of the sieve buffer in bits, the odd only layout keeps
+// 1 bit per odd number, so a block covers (1 << 19) numbers with a 32KB
+// buffer, witch is about the size of a L1 cache.
+//
+// the wheel layouts pack more numbers into the same buffer.
+//
+// the kernels are written once as always inline functions, then wrapped in a
+// function for each instruction set, (see PRIME_GENERATOR_KERNEL_VARIANTS)
+// so the compiler makes a separate copy of them for each one.
+//
+#define Prime_Generator_Kernel    static inline __attribute__((always_inline))
+
+#if PRIME_GENERATOR_DISPATCH
+    #define PRIME_GENERATOR_TARGET_AVX2      __attribute__((target("popcnt,lzcnt,bmi,bmi2,avx2")))
+    #define PRIME_GENERATOR_TARGET_AVX512    __attribute__((target("popcnt,lzcnt,bmi,bmi2,avx2,avx512f,avx512bw,avx512vl,avx512dq")))
+#endif // PRIME_GENERATOR_DISPATCH
+
+
+#ifndef PRIME_GENERATOR_BLOCK_SIZE
+    #define PRIME_GENERATOR_BLOCK_SIZE    (1 << 19)
+#endif // PRIME_GENERATOR_BLOCK_SIZE
+
+#define PRIME_GENERATOR_BLOCK_BITS    (PRIME_GENERATOR_BLOCK_SIZE / 2)
+#define PRIME_GENERATOR_BLOCK_WORDS   (PRIME_GENERATOR_BLOCK_BITS / 64)
+
+// every block starts as a copy of a pattern that has the multiples
+// of the primes upto this number allready crossed off.
+//
+// the pattern repeats every (product of those primes) turns of the wheel,
+// 17 keeps the pattern around 32KB for the odd only layout, 19 is about 600KB.
+#ifndef PRIME_GENERATOR_PRE_SIEVE_LIMIT
+    #define PRIME_GENERATOR_PRE_SIEVE_LIMIT    17
+#endif // PRIME_GENERATOR_PRE_SIEVE_LIMIT
+
+PRIME_GENERATOR_STATIC_ASSERT((PRIME_GENERATOR_BLOCK_SIZE & (PRIME_GENERATOR_BLOCK_SIZE - 1)) == 0, "PRIME_GENERATOR_BLOCK_SIZE must be a power of 2");
+PRIME_GENERATOR_STATIC_ASSERT(PRIME_GENERATOR_PRE_SIEVE_LIMIT <= 23, "the pre sieve pattern gets way to big after 23");
+PRIME_GENERATOR_STATIC_ASSERT(PRIME_GENERATOR_BLOCK_SIZE >= (1 << 14), "PRIME_GENERATOR_BLOCK_SIZE must be able to fit a couple wheel turns");
+
+
+#define PRIME_GENERATOR_MAX_WHEEL_MODULUS     210
+#define PRIME_GENERATOR_MAX_WHEEL_RESIDUES    48
+
+// not coprime to the wheel, used in 'residue_index'
+#define PRIME_GENERATOR_NOT_ON_WHEEL          0xFF
+
+
+//
+// how to move from one multiple of a prime to the next one on the wheel.
+//
+// a multiple 'prime * k' is tracked as a (turn, step index) pair,
+// where k's residue is 'residues[step_index % residue_count]' and
+// the primes residue is 'residues[step_index / residue_count]'.
+//
+typedef struct Prime_Generator_Wheel_Step {
+    // the bit of the multiple inside its turn.
+    uint16_t bit;
+    // step index of the next multiple.
+    uint16_t next;
+    // k goes up by 'gap', so the turn goes up by 'gap * (prime / modulus) + carry'
+    uint8_t  gap;
+    uint8_t  carry;
+    // when k = 'c * modulus + residues[j]', the turn is 'c * prime + residues[j] * (prime / modulus) + cycle_carry'
+    uint8_t  cycle_carry;
+} Prime_Generator_Wheel_Step;
+
+struct Prime_Generator_Wheel {
+    Prime_Generator_Layout layout;
+    // the kernels we actually sieve with, never AUTO.
+    Prime_Generator_Isa isa;
+    // what the generator was started with, so we can tell if someone changes it.
+    Prime_Generator_Storage storage;
+    bool keep_bitmap;
+
+    // numbers per turn of the wheel.
+    u64 modulus;
+    // numbers coprime to modulus in one turn, (bits per turn)
+    u64 residue_count;
+    // how many of the first primes divide the modulus, these are never sieved with.
+    u64 wheel_prime_count;
+
+    // always a power of 2, so the bucket sieve can shift instead of divide.
+    u64 turns_per_block;
+    u64 turns_per_block_shift;
+    u64 bits_per_block;
+    u64 numbers_per_block;
+
+    // where the first block ends, the first block is made with 'get_primes_upto_number()'
+    u64 first_block_end;
+
+    uint8_t residues     [PRIME_GENERATOR_MAX_WHEEL_RESIDUES];
+    uint8_t residue_index[PRIME_GENERATOR_MAX_WHEEL_MODULUS];
+    // distance from n to the next number coprime to modulus.
+    uint8_t next_coprime [PRIME_GENERATOR_MAX_WHEEL_MODULUS];
+
+    Prime_Generator_Wheel_Step steps[PRIME_GENERATOR_MAX_WHEEL_RESIDUES * PRIME_GENERATOR_MAX_WHEEL_RESIDUES];
+
+    // the bits in a u64 dont always line up with the turns, (48 bits per turn for wheel 210)
+    // but after 'words_per_cycle' words they do, thats 'numbers_per_cycle' numbers.
+    //
+    // bit 'b' of the cycle is the number 'bit_offsets[b]' after the start of the cycle.
+    u64 words_per_cycle;
+    u64 numbers_per_cycle;
+    uint16_t bit_offsets[3 * 64];
+
+    // primes before this index are either in the wheel or in the pre sieve pattern.
+    u64 first_sieving_prime_index;
+
+    // the pre sieve pattern, 'pre_sieve_turns' turns long, with 2 extra words
+    // at the end that wrap back around, so we can read 64 bits from anywhere.
+    u64 *pre_sieve_pattern;
+    u64  pre_sieve_turns;
+};
+
+
+// find the first multiple 'prime * k' at or after 'block_start', where k is
+// the smallest number on the wheel thats >= 'min_k'.
+//
+// the multiple is returned as the turn after 'block_start' it lands in,
+// and the step index to walk around the wheel with.
+//
+// this dose a division, so dont call it in the middle of anything hot.
+Prime_Generator_Internal void __first_multiple_on_wheel(const Prime_Generator_Wheel *wheel, u64 block_start, u64 prime, u64 min_k, u64 *turn, u64 *step_index) {
+    const u64 R       = wheel->residue_count;
+    const u64 modulus = wheel->modulus;
+
+    // do a bunch of math to figure of what position we start at in the array
+    u64 k = (block_start + prime - 1) / prime;
+    if (k < min_k) k = min_k;
+    k += wheel->next_coprime[k % modulus];
+
+    *turn       = (prime * k - block_start) / modulus;
+    *step_index = wheel->residue_index[prime % modulus] * R + wheel->residue_index[k % modulus];
+}
+
+
+// cross off the multiples 'prime * k' in a block of 'turns' turns, k starts at the
+// smallest number on the wheel thats >= 'min_k', and the block starts at 'block_start'.
+Prime_Generator_Internal void __cross_off_prime(const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits, u64 turns, u64 block_start, u64 prime, u64 min_k) {
+    const u64 R       = wheel->residue_count;
+    const u64 modulus = wheel->modulus;
+
+    u64 turn, step_index;
+    __first_multiple_on_wheel(wheel, block_start, prime, min_k, &turn, &step_index);
+
+    if (R == 1) {
+        // technically were iterating by 'prime * 2 / 2'
+        //     / 2 because we removed the even cells
+        //     * 2 because all multiples of 2 are gone. and we dont need to check them.
+        for (u64 j = turn; j < turns; j += prime) {
+            is_not_prime_bits[j / 64] |= 1ULL << (j % 64);
+        }
+    } else {
+        // walk around the wheel, skipping k's that would land on a number without a cell.
+        u64 prime_div_modulus = prime / modulus;
+
+        while (turn < turns) {
+            const Prime_Generator_Wheel_Step *step = &wheel->steps[step_index];
+            u64 j = turn * R + step->bit;
+            is_not_prime_bits[j / 64] |= 1ULL << (j % 64);
+
+            turn      += step->gap * prime_div_modulus + step->carry;
+            step_index = step->next;
+        }
+    }
+}
+
+
+// how many words the pre sieve pattern takes, with the 2 that wrap around,
+// the allocation and the free both use this, so they cant disagree.
+Prime_Generator_Internal u64 __pre_sieve_pattern_words(const Prime_Generator_Wheel *wheel) {
+    return (wheel->pre_sieve_turns * wheel->residue_count + 63) / 64 + 2;
+}
+
+// make the pre sieve pattern, assumes the rest of the wheel is allready made.
+Prime_Generator_Internal bool __build_pre_sieve_pattern(Prime_Generator_Wheel *wheel) {
+    const u64 small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23};
+
+    wheel->pre_sieve_turns = 1;
+    wheel->first_sieving_prime_index = wheel->wheel_prime_count;
+    for (size_t i = wheel->wheel_prime_count; i < sizeof(small_primes)/sizeof(small_primes[0]); i++) {
+        if (small_primes[i] > PRIME_GENERATOR_PRE_SIEVE_LIMIT) break;
+        // the pattern repeats when all the primes line up again.
+        wheel->pre_sieve_turns *= small_primes[i];
+        wheel->first_sieving_prime_index = i + 1;
+    }
+
+    u64 pattern_bits  = wheel->pre_sieve_turns * wheel->residue_count;
+    u64 pattern_words = __pre_sieve_pattern_words(wheel);
+
+    u64 *pattern = PRIME_GENERATOR_REALLOC(NULL, 0, pattern_words * sizeof(u64));
+    if (!pattern) {
+        PRIME_GENERATOR_ASSERT(pattern && "You ran out of memory, how?");
+        return false;
+    }
+    PRIME_GENERATOR_MEM_ZERO(pattern, pattern_words * sizeof(u64));
+
+    // the small primes themselves get crossed off here,
+    // thats fine, they only ever show up in the first block.
+    for (size_t i = wheel->wheel_prime_count; i < wheel->first_sieving_prime_index; i++) {
+        __cross_off_prime(wheel, pattern, wheel->pre_sieve_turns, 0, small_primes[i], 1);
+    }
+
+    // copy the start onto the end, so reads can run off the end.
+    for (u64 bit = pattern_bits; bit < pattern_words * 64; bit++) {
+        u64 from = bit - pattern_bits;
+        if (pattern[from / 64] & (1ULL << (from % 64))) pattern[bit / 64] |= 1ULL << (bit % 64);
+    }
+
+    wheel->pre_sieve_pattern = pattern;
+    return true;
+}
+
+
+// start a block off with the pre sieve pattern, lined up with 'block_start'.
+Prime_Generator_Kernel void __pre_sieve_block(const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits, u64 word_count, u64 block_start) {
+    const u64 *pattern = wheel->pre_sieve_pattern;
+    u64 pattern_bits = wheel->pre_sieve_turns * wheel->residue_count;
+
+    // a memcpy, but the pattern is in bits, so it might not line up with the words.
+    u64 position = ((block_start / wheel->modulus) % wheel->pre_sieve_turns) * wheel->residue_count;
+    for (u64 i = 0; i < word_count; i++) {
+        u64 word  = position / 64;
+        u64 shift = position % 64;
+
+        is_not_prime_bits[i] = shift ? (pattern[word] >> shift) | (pattern[word+1] << (64 - shift))
+                                     :  pattern[word];
+
+        position += 64;
+        if (position >= pattern_bits) position -= pattern_bits;
+    }
+}
+
+
+// fill out the lookup tables for a layout.
+Prime_Generator_Internal bool __build_prime_generator_wheel(Prime_Generator_Wheel *wheel, Prime_Generator_Layout layout) {
+    PRIME_GENERATOR_MEM_ZERO(wheel, sizeof(*wheel));
+
+    u64 modulus, wheel_prime_count;
+    switch (layout) {
+        case PRIME_GENERATOR_LAYOUT_ODD_ONLY:  { modulus =   2; wheel_prime_count = 1; } break;
+        case PRIME_GENERATOR_LAYOUT_WHEEL_30:  { modulus =  30; wheel_prime_count = 3; } break;
+        case PRIME_GENERATOR_LAYOUT_WHEEL_210: { modulus = 210; wheel_prime_count = 4; } break;
+
+        default: {
+            PRIME_GENERATOR_ASSERT(false && "unknown Prime_Generator_Layout");
+            return false;
+        }
+    }
+
+    wheel->layout            = layout;
+    wheel->modulus           = modulus;
+    wheel->wheel_prime_count = wheel_prime_count;
+
+    // find the residues, good old gcd.
+    for (u64 n = 0; n < modulus; n++) {
+        u64 a = n, b = modulus;
+        while (b) { u64 t = a % b; a = b; b = t; }
+
+        if (a == 1) {
+            wheel->residue_index[n] = wheel->residue_count;
+            wheel->residues[wheel->residue_count++] = n;
+        } else {
+            wheel->residue_index[n] = PRIME_GENERATOR_NOT_ON_WHEEL;
+        }
+    }
+
+    for (u64 n = 0; n < modulus; n++) {
+        u64 distance = 0;
+        while (wheel->residue_index[(n + distance) % modulus] == PRIME_GENERATOR_NOT_ON_WHEEL) distance += 1;
+        wheel->next_coprime[n] = distance;
+    }
+
+    u64 R = wheel->residue_count;
+
+    // biggest power of 2 number of turns that fits in the buffer.
+    wheel->turns_per_block       = 1;
+    wheel->turns_per_block_shift = 0;
+    while (wheel->turns_per_block * 2 * R <= PRIME_GENERATOR_BLOCK_BITS) {
+        wheel->turns_per_block       *= 2;
+        wheel->turns_per_block_shift += 1;
+    }
+
+    wheel->bits_per_block    = wheel->turns_per_block * R;
+    wheel->numbers_per_block = wheel->turns_per_block * modulus;
+
+    // make the first block end on a whole u64 of turns, so the blocks after it line up nicely.
+    u64 numbers_per_64_turns = modulus * 64;
+    wheel->first_block_end = (PRIME_GENERATOR_BLOCK_SIZE + numbers_per_64_turns - 1) / numbers_per_64_turns * numbers_per_64_turns;
+
+    // 64 / gcd(64, R) turns fit exactly in R / gcd(64, R) words.
+    u64 gcd_of_64_and_R = R & (~R + 1);
+    if (gcd_of_64_and_R > 64) gcd_of_64_and_R = 64;
+    wheel->words_per_cycle   = R / gcd_of_64_and_R;
+    wheel->numbers_per_cycle = (64 / gcd_of_64_and_R) * modulus;
+    for (u64 b = 0; b < wheel->words_per_cycle * 64; b++) {
+        wheel->bit_offsets[b] = (b / R) * modulus + wheel->residues[b % R];
+    }
+
+    // the multiple 'prime * k', where prime has residue index 'i', and k has residue index 'j'.
+    for (u64 i = 0; i < R; i++) {
+        for (u64 j = 0; j < R; j++) {
+            u64 prime_residue    = wheel->residues[i];
+            u64 multiple_residue = (prime_residue * wheel->residues[j]) % modulus;
+
+            u64 next_residue = (j + 1 < R) ? (u64) wheel->residues[j+1] : (u64) wheel->residues[0] + modulus;
+            u64 gap = next_residue - wheel->residues[j];
+
+            Prime_Generator_Wheel_Step *step = &wheel->steps[i*R + j];
+            step->bit   = wheel->residue_index[multiple_residue];
+            step->next  = i*R + (j + 1) % R;
+            step->gap   = gap;
+            step->carry = (multiple_residue + gap * prime_residue) / modulus;
+            step->cycle_carry = (prime_residue * wheel->residues[j]) / modulus;
+        }
+    }
+
+    return true;
+}
+
+
+Prime_Generator_Internal void __free_prime_generator_wheel(Prime_Generator_Wheel *wheel) {
+    if (!wheel) return;
+
+    PRIME_GENERATOR_FREE(wheel->pre_sieve_pattern, __pre_sieve_pattern_words(wheel) * sizeof(u64));
+    PRIME_GENERATOR_FREE(wheel, sizeof(Prime_Generator_Wheel));
+}
+
+
+// the best instruction set this cpu can do, uses cpuid.
+Prime_Generator_Internal Prime_Generator_Isa __prime_generator_best_isa(void) {
+    #if PRIME_GENERATOR_DISPATCH
+        __builtin_cpu_init();
+
+        bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("popcnt");
+        if (avx2 && __builtin_cpu_supports("avx512f")  && __builtin_cpu_supports("avx512bw")
+                 && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq")) {
+            return PRIME_GENERATOR_ISA_AVX512;
+        }
+        if (avx2) return PRIME_GENERATOR_ISA_AVX2;
+    #endif // PRIME_GENERATOR_DISPATCH
+
+    return PRIME_GENERATOR_ISA_BASELINE;
+}
+
+
+// make the wheel if we have not started yet.
+Prime_Generator_Internal bool __prime_generator_wheel_init(Prime_Generator *prime_generator) {
+    if (prime_generator->isa >= PRIME_GENERATOR_ISA_COUNT) {
+        PRIME_GENERATOR_ASSERT(prime_generator->isa < PRIME_GENERATOR_ISA_COUNT && "not a valid isa, see 'Prime_Generator_Isa'");
+        return false;
+    }
+
+    if (prime_generator->storage >= PRIME_GENERATOR_STORAGE_COUNT) {
+        PRIME_GENERATOR_ASSERT(prime_generator->storage < PRIME_GENERATOR_STORAGE_COUNT && "not a valid storage, see 'Prime_Generator_Storage'");
+        return false;
+    }
+
+    if (prime_generator->wheel) {
+        if (prime_generator->wheel->layout != prime_generator->layout) {
+            PRIME_GENERATOR_ASSERT(prime_generator->wheel->layout == prime_generator->layout && "cannot change the layout of a generator thats already started, clear it first");
+            return false;
+        }
+        if (prime_generator->wheel->storage != prime_generator->storage) {
+            PRIME_GENERATOR_ASSERT(prime_generator->wheel->storage == prime_generator->storage && "cannot change the storage of a generator thats already started, clear it first");
+            return false;
+        }
+        if (prime_generator->wheel->keep_bitmap != prime_generator->keep_bitmap) {
+            PRIME_GENERATOR_ASSERT(prime_generator->wheel->keep_bitmap == prime_generator->keep_bitmap && "cannot change keep_bitmap of a generator thats already started, the start of the bitmap would be missing, clear it first");
+            return false;
+        }
+        return true;
+    }
+
+    Prime_Generator_Wheel *wheel = PRIME_GENERATOR_REALLOC(NULL, 0, sizeof(Prime_Generator_Wheel));
+    if (!wheel) {
+        PRIME_GENERATOR_ASSERT(wheel && "You ran out of memory, how?");
+        return false;
+    }
+    if (!__build_prime_generator_wheel(wheel, prime_generator->layout)) {
+        PRIME_GENERATOR_FREE(wheel, sizeof(Prime_Generator_Wheel));
+        return false;
+    }
+    if (!__build_pre_sieve_pattern(wheel)) {
+        PRIME_GENERATOR_FREE(wheel, sizeof(Prime_Generator_Wheel));
+        return false;
+    }
+
+    // pick the kernels once, instead of checking the cpu every block.
+    Prime_Generator_Isa best = __prime_generator_best_isa();
+    wheel->isa = prime_generator->isa;
+    if (wheel->isa == PRIME_GENERATOR_ISA_AUTO || wheel->isa > best) wheel->isa = best;
+
+    wheel->storage     = prime_generator->storage;
+    wheel->keep_bitmap = prime_generator->keep_bitmap;
+
+    prime_generator->wheel = wheel;
+    return true;
+}
+
+
+// how many primes are in a block, every bit that is still 0 is a prime.
+Prime_Generator_Kernel u64 __count_primes_in_block(const u64 *is_not_prime_bits, u64 word_count) {
+    u64 count = 0;
+    for (u64 i = 0; i < word_count; i++) count += 64 - PRIME_GENERATOR_POPCOUNT(is_not_prime_bits[i]);
+    return count;
+}
+
+// the extraction writes a little past the last prime, so leave this much room after them.
+#define PRIME_GENERATOR_EXTRACT_SLACK    64
+
+// pull the primes out of a block, every bit that is still 0 is a prime.
+//
+// 'out' must have room for all of them, plus PRIME_GENERATOR_EXTRACT_SLACK,
+// returns a pointer just past the last prime.
+//
+// instead of testing every bit, we jump straight to the primes with
+// count trailing zeros, and clear them with 'x & (x-1)'.
+Prime_Generator_Kernel u64 *__extract_primes_from_block_scalar(u64 *out, const u64 *is_not_prime_bits, u64 word_count, u64 block_start, const Prime_Generator_Wheel *wheel) {
+    u64 cycle_start = block_start;
+    for (u64 i = 0; i < word_count; i += wheel->words_per_cycle) {
+        for (u64 w = 0; w < wheel->words_per_cycle; w++) {
+            const uint16_t *offsets = &wheel->bit_offsets[w * 64];
+
+            u64 primes = ~is_not_prime_bits[i + w];
+            u64 count  = PRIME_GENERATOR_POPCOUNT(primes);
+
+            // always do 8, most words have less than that, so the loop below is almost never taken.
+            //
+            // these run off the end when there are less than 8, thats what the slack is for,
+            // the top bit keeps ctz away from 0.
+            for (u64 k = 0; k < 8; k++) {
+                out[k] = cycle_start + offsets[PRIME_GENERATOR_CTZ(primes | (1ULL << 63))];
+                primes &= primes - 1;
+            }
+            for (u64 k = 8; k < count; k++) {
+                out[k] = cycle_start + offsets[PRIME_GENERATOR_CTZ(primes)];
+                primes &= primes - 1;
+            }
+
+            out += count;
+        }
+        cycle_start += wheel->numbers_per_cycle;
+    }
+    return out;
+}
+
+
+#if PRIME_GENERATOR_DISPATCH
+
+// same as the scalar one, but 8 bits at a time, with a compress.
+//
+// compressing into a register and storing all 8 is a lot faster than
+// the compress store straight to memory, thats what the slack is for.
+PRIME_GENERATOR_TARGET_AVX512
+Prime_Generator_Internal u64 *__extract_primes_from_block_avx512(u64 *out, const u64 *is_not_prime_bits, u64 word_count, u64 block_start, const Prime_Generator_Wheel *wheel) {
+    u64 cycle_start = block_start;
+    for (u64 i = 0; i < word_count; i += wheel->words_per_cycle) {
+        __m512i start = _mm512_set1_epi64((long long) cycle_start);
+
+        for (u64 w = 0; w < wheel->words_per_cycle; w++) {
+            const uint16_t *offsets = &wheel->bit_offsets[w * 64];
+            u64 primes = ~is_not_prime_bits[i + w];
+
+            for (u64 k = 0; k < 8; k++) {
+                __mmask8 mask = (__mmask8)(primes >> (k * 8));
+                __m512i numbers = _mm512_add_epi64(start, _mm512_cvtepu16_epi64(_mm_loadu_si128((const __m128i *) &offsets[k * 8])));
+
+                _mm512_storeu_si512((void *) out, _mm512_maskz_compress_epi64(mask, numbers));
+                out += PRIME_GENERATOR_POPCOUNT(mask);
+            }
+        }
+        cycle_start += wheel->numbers_per_cycle;
+    }
+    return out;
+}
+
+#endif // PRIME_GENERATOR_DISPATCH
+
+
+/////////////////////////////////////////////////
+//               BUCKET SIEVE
+/////////////////////////////////////////////////
+
+struct Prime_Generator_Sieving_Prime {
+    // the prime is 'prime_div_modulus * modulus + residues[step_index / residue_count]'
+    uint32_t prime_div_modulus;
+    // turn inside the block it hits next.
+    uint32_t turn;
+    uint32_t step_index;
+};
+
+// about 12KB of entries, so a couple buckets fit in L2 alongside the block.
+#ifndef PRIME_GENERATOR_BUCKET_CAPACITY
+    #define PRIME_GENERATOR_BUCKET_CAPACITY    1024
+#endif // PRIME_GENERATOR_BUCKET_CAPACITY
+
+struct Prime_Generator_Bucket {
+    Prime_Generator_Bucket *next;
+    u64 count;
+    Prime_Generator_Sieving_Prime entries[PRIME_GENERATOR_BUCKET_CAPACITY];
+};
+
+
+// make sure the ring can hold a prime that will hit a block 'blocks_ahead' blocks from now.
+Prime_Generator_Internal bool __bucket_sieve_reserve(Prime_Generator_Bucket_Sieve *bucket_sieve, u64 blocks_ahead) {
+    if (blocks_ahead < bucket_sieve->ring_size) return true;
+
+    u64 new_ring_size = bucket_sieve->ring_size ? bucket_sieve->ring_size : 8;
+    while (new_ring_size <= blocks_ahead) new_ring_size *= 2;
+
+    Prime_Generator_Bucket **new_ring = PRIME_GENERATOR_REALLOC(NULL, 0, new_ring_size * sizeof(Prime_Generator_Bucket *));
+    if (!new_ring) {
+        PRIME_GENERATOR_ASSERT(new_ring && "You ran out of memory, how many primes did you just try to make?");
+        return false;
+    }
+    PRIME_GENERATOR_MEM_ZERO(new_ring, new_ring_size * sizeof(Prime_Generator_Bucket *));
+
+    // move the lists into their new slots, they keep the same block number.
+    for (u64 i = 0; i < bucket_sieve->ring_size; i++) {
+        u64 block_number = bucket_sieve->block_number + ((i - bucket_sieve->block_number) & (bucket_sieve->ring_size - 1));
+        new_ring[block_number & (new_ring_size - 1)] = bucket_sieve->ring[i];
+    }
+
+    PRIME_GENERATOR_FREE(bucket_sieve->ring, bucket_sieve->ring_size * sizeof(Prime_Generator_Bucket *));
+    bucket_sieve->ring      = new_ring;
+    bucket_sieve->ring_size = new_ring_size;
+    return true;
+}
+
+// put a prime in the bucket for the block its going to hit.
+Prime_Generator_Internal void __bucket_sieve_push(Prime_Generator_Bucket_Sieve *bucket_sieve, u64 block_number, Prime_Generator_Sieving_Prime entry) {
+    Prime_Generator_Bucket **head = &bucket_sieve->ring[block_number & (bucket_sieve->ring_size - 1)];
+
+    if (!*head || (*head)->count == PRIME_GENERATOR_BUCKET_CAPACITY) {
+        Prime_Generator_Bucket *bucket = bucket_sieve->free_buckets;
+        if (bucket) {
+            bucket_sieve->free_buckets = bucket->next;
+        } else {
+            bucket = PRIME_GENERATOR_REALLOC(NULL, 0, sizeof(Prime_Generator_Bucket));
+            if (!bucket) {
+                PRIME_GENERATOR_ASSERT(bucket && "You ran out of memory, how many primes did you just try to make?");
+                return;
+            }
+        }
+        bucket->count = 0;
+        bucket->next  = *head;
+        *head = bucket;
+    }
+
+    (*head)->entries[(*head)->count++] = entry;
+}
+
+// add a new prime to the bucket sieve, it must be bigger than a block.
+Prime_Generator_Internal void __bucket_sieve_add_prime(Prime_Generator_Bucket_Sieve *bucket_sieve, const Prime_Generator_Wheel *wheel, u64 block_start, u64 prime) {
+    u64 turn, step_index;
+    __first_multiple_on_wheel(wheel, block_start, prime, prime, &turn, &step_index);
+
+    // the furthest a prime can jump in one step, plus the block its in now.
+    u64 prime_div_modulus = prime / wheel->modulus;
+    u64 biggest_jump = (prime_div_modulus + 1) * wheel->modulus;
+    if (!__bucket_sieve_reserve(bucket_sieve, (turn + biggest_jump) >> wheel->turns_per_block_shift)) return;
+
+    Prime_Generator_Sieving_Prime entry = {
+        .prime_div_modulus = prime_div_modulus,
+        .turn              = turn & (wheel->turns_per_block - 1),
+        .step_index        = step_index,
+    };
+    __bucket_sieve_push(bucket_sieve, bucket_sieve->block_number + (turn >> wheel->turns_per_block_shift), entry);
+}
+
+// cross off every prime waiting for this block, and send them on to the next block they hit.
+Prime_Generator_Kernel void __bucket_sieve_block(Prime_Generator_Bucket_Sieve *bucket_sieve, const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits) {
+    const u64 R = wheel->residue_count;
+
+    if (bucket_sieve->ring_size) {
+        Prime_Generator_Bucket **head = &bucket_sieve->ring[bucket_sieve->block_number & (bucket_sieve->ring_size - 1)];
+        Prime_Generator_Bucket *bucket = *head;
+        *head = NULL;
+
+        while (bucket) {
+            for (u64 i = 0; i < bucket->count; i++) {
+                Prime_Generator_Sieving_Prime entry = bucket->entries[i];
+                const Prime_Generator_Wheel_Step *step = &wheel->steps[entry.step_index];
+
+                u64 j = entry.turn * R + step->bit;
+                is_not_prime_bits[j / 64] |= 1ULL << (j % 64);
+
+                // these primes are bigger than a block, so this always lands in a later block.
+                u64 turn = entry.turn + step->gap * entry.prime_div_modulus + step->carry;
+                entry.turn       = turn & (wheel->turns_per_block - 1);
+                entry.step_index = step->next;
+                __bucket_sieve_push(bucket_sieve, bucket_sieve->block_number + (turn >> wheel->turns_per_block_shift), entry);
+            }
+
+            // recycle the bucket.
+            Prime_Generator_Bucket *next = bucket->next;
+            bucket->next = bucket_sieve->free_buckets;
+            bucket_sieve->free_buckets = bucket;
+            bucket = next;
+        }
+    }
+
+    bucket_sieve->block_number += 1;
+}
+
+Prime_Generator_Internal void __free_bucket_list(Prime_Generator_Bucket *bucket) {
+    while (bucket) {
+        Prime_Generator_Bucket *next = bucket->next;
+        PRIME_GENERATOR_FREE(bucket, sizeof(Prime_Generator_Bucket));
+        bucket = next;
+    }
+}
+
+Prime_Generator_Internal void __free_bucket_sieve(Prime_Generator_Bucket_Sieve *bucket_sieve) {
+    for (u64 i = 0; i < bucket_sieve->ring_size; i++) __free_bucket_list(bucket_sieve->ring[i]);
+    __free_bucket_list(bucket_sieve->free_buckets);
+    PRIME_GENERATOR_FREE(bucket_sieve->ring, bucket_sieve->ring_size * sizeof(Prime_Generator_Bucket *));
+
+    PRIME_GENERATOR_MEM_ZERO(bucket_sieve, sizeof(*bucket_sieve));
+}
+
+
+
+/////////////////////////////////////////////////
+//                 THE SIEVE
+/////////////////////////////////////////////////
+
+// start sieving with any new primes that hit a block ending at 'block_end'.
+//
+// 'primes' must be every prime in order, (starting with 2), and the sieve
+// remembers how far through them it is, so just pass the same array every time.
+Prime_Generator_Internal void __sieve_add_primes(Prime_Generator_Sieve *sieve, const Prime_Generator_Wheel *wheel, const u64 *primes, u64 prime_count, u64 block_end) {
+    // skip the primes in the wheel and the pattern, they are allready done.
+    if (sieve->next_prime_index < wheel->first_sieving_prime_index) sieve->next_prime_index = wheel->first_sieving_prime_index;
+
+    u64 sqrt_of_ending = int_sqrt(block_end);
+    for (; sieve->next_prime_index < prime_count; sieve->next_prime_index++) {
+        u64 prime = primes[sieve->next_prime_index];
+        if (prime > sqrt_of_ending) break;
+
+        // the big ones go in the buckets.
+        if (prime > wheel->numbers_per_block) {
+            __bucket_sieve_add_prime(&sieve->bucket_sieve, wheel, sieve->block_start, prime);
+            continue;
+        }
+
+        if (sieve->sieving_prime_count >= sieve->sieving_prime_capacity) {
+            u64 new_capacity = sieve->sieving_prime_capacity ? sieve->sieving_prime_capacity * 2 : 256;
+            Prime_Generator_Sieving_Prime *new_sieving_primes = PRIME_GENERATOR_REALLOC(
+                sieve->sieving_primes,
+                sieve->sieving_prime_capacity * sizeof(Prime_Generator_Sieving_Prime),
+                new_capacity * sizeof(Prime_Generator_Sieving_Prime)
+            );
+            if (!new_sieving_primes) {
+                PRIME_GENERATOR_ASSERT(new_sieving_primes && "You ran out of memory, how many primes did you just try to make?");
+                return;
+            }
+            sieve->sieving_primes         = new_sieving_primes;
+            sieve->sieving_prime_capacity = new_capacity;
+        }
+
+        // the only division this prime will ever see.
+        u64 turn, step_index;
+        __first_multiple_on_wheel(wheel, sieve->block_start, prime, prime, &turn, &step_index);
+
+        sieve->sieving_primes[sieve->sieving_prime_count++] = (Prime_Generator_Sieving_Prime){
+            .prime_div_modulus = prime / wheel->modulus,
+            .turn              = turn,
+            .step_index        = step_index,
+        };
+    }
+}
+
+
+// cross off the primes smaller than a block, and move them onto the next block.
+Prime_Generator_Kernel void __cross_off_sieving_primes(const Prime_Generator_Wheel *wheel, Prime_Generator_Sieving_Prime *sieving_primes, u64 sieving_prime_count, u64 *is_not_prime_bits) {
+    const u64 R     = wheel->residue_count;
+    const u64 turns = wheel->turns_per_block;
+
+    if (R == 1) {
+        for (u64 i = 0; i < sieving_prime_count; i++) {
+            Prime_Generator_Sieving_Prime *sieving_prime = &sieving_primes[i];
+            u64 prime = sieving_prime->prime_div_modulus * 2 + 1;
+
+            // technically were iterating by 'prime * 2 / 2'
+            //     / 2 because we removed the even cells
+            //     * 2 because all multiples of 2 are gone. and we dont need to check them.
+            u64 j = sieving_prime->turn;
+            for (; j < turns; j += prime) {
+                is_not_prime_bits[j / 64] |= 1ULL << (j % 64);
+            }
+            sieving_prime->turn = j - turns;
+        }
+    } else {
+        for (u64 i = 0; i < sieving_prime_count; i++) {
+            Prime_Generator_Sieving_Prime *sieving_prime = &sieving_primes[i];
+            u64 prime_div_modulus = sieving_prime->prime_div_modulus;
+            u64 turn              = sieving_prime->turn;
+            u64 step_index        = sieving_prime->step_index;
+
+            u64 prime_residue_index = step_index / R;
+            u64 prime = prime_div_modulus * wheel->modulus + wheel->residues[prime_residue_index];
+
+            // walking the steps is a chain of loads, every multiple waits on the last one.
+            //
+            // but every 'prime' turns the multiples come back to the same bits, (k went up by modulus)
+            // so for the small primes, do each bit on its own, like the odd only layout.
+            // one run for each residue of k, none of them depend on each other.
+            if (prime < turns) {
+                const Prime_Generator_Wheel_Step *steps = &wheel->steps[prime_residue_index * R];
+                u64 first_j = step_index - prime_residue_index * R;
+
+                // the turn 'k = c * modulus' lands on, for the k we are up to,
+                // this can be before the block, but its unsigned so it wraps back around.
+                u64 cycle_turn = turn - (wheel->residues[first_j] * prime_div_modulus + steps[first_j].cycle_carry);
+
+                u64 next_bit = ~0ULL;
+                u64 next_j   = 0;
+                for (u64 j = 0; j < R; j++) {
+                    u64 t = cycle_turn + wheel->residues[j] * prime_div_modulus + steps[j].cycle_carry;
+                    // these ones came before the k we are up to, so they are done for this cycle.
+                    if (j < first_j) t += prime;
+
+                    u64 bit = t * R + steps[j].bit;
+                    for (; bit < turns * R; bit += prime * R) {
+                        is_not_prime_bits[bit / 64] |= 1ULL << (bit % 64);
+                    }
+
+                    // the first multiple past the block is where we pick up next time.
+                    if (bit < next_bit) {
+                        next_bit = bit;
+                        next_j   = j;
+                    }
+                }
+
+                sieving_prime->turn       = next_bit / R - turns;
+                sieving_prime->step_index = prime_residue_index * R + next_j;
+                continue;
+            }
+
+            // walk around the wheel, skipping k's that would land on a number without a cell.
+            while (turn < turns) {
+                const Prime_Generator_Wheel_Step *step = &wheel->steps[step_index];
+                u64 j = turn * R + step->bit;
+                is_not_prime_bits[j / 64] |= 1ULL << (j % 64);
+
+                turn      += step->gap * prime_div_modulus + step->carry;
+                step_index = step->next;
+            }
+
+            sieving_prime->turn       = turn - turns;
+            sieving_prime->step_index = step_index;
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////
+//               KERNEL DISPATCH
+/////////////////////////////////////////////////
+
+// the hot parts of sieving a block, one set for each 'Prime_Generator_Isa'
+typedef struct Prime_Generator_Kernels {
+    void (*pre_sieve)(const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits, u64 word_count, u64 block_start);
+    // the sieving primes and the bucket sieve.
+    void (*cross_off)(Prime_Generator_Sieve *sieve, const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits);
+    u64  (*count)(const u64 *is_not_prime_bits, u64 word_count);
+    u64 *(*extract)(u64 *out, const u64 *is_not_prime_bits, u64 word_count, u64 block_start, const Prime_Generator_Wheel *wheel);
+} Prime_Generator_Kernels;
+
+// makes a copy of every kernel for the instruction set 'target'
+#define PRIME_GENERATOR_KERNEL_VARIANTS(suffix, target)                                                                                         \
+    target Prime_Generator_Internal void __pre_sieve_block_##suffix(const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits, u64 word_count, u64 block_start) { \
+        __pre_sieve_block(wheel, is_not_prime_bits, word_count, block_start);                                                                   \
+    }                                                                                                                                           \
+    target Prime_Generator_Internal void __cross_off_##suffix(Prime_Generator_Sieve *sieve, const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits) { \
+        __cross_off_sieving_primes(wheel, sieve->sieving_primes, sieve->sieving_prime_count, is_not_prime_bits);                               \
+        __bucket_sieve_block(&sieve->bucket_sieve, wheel, is_not_prime_bits);                                                                   \
+    }                                                                                                                                           \
+    target Prime_Generator_Internal u64 __count_primes_in_block_##suffix(const u64 *is_not_prime_bits, u64 word_count) {                       \
+        return __count_primes_in_block(is_not_prime_bits, word_count);                                                                          \
+    }
+
+PRIME_GENERATOR_KERNEL_VARIANTS(baseline, )
+
+Prime_Generator_Internal u64 *__extract_primes_from_block_baseline(u64 *out, const u64 *is_not_prime_bits, u64 word_count, u64 block_start, const Prime_Generator_Wheel *wheel) {
+    return __extract_primes_from_block_scalar(out, is_not_prime_bits, word_count, block_start, wheel);
+}
+
+#if PRIME_GENERATOR_DISPATCH
+    PRIME_GENERATOR_KERNEL_VARIANTS(avx2,   PRIME_GENERATOR_TARGET_AVX2)
+    PRIME_GENERATOR_KERNEL_VARIANTS(avx512, PRIME_GENERATOR_TARGET_AVX512)
+
+    // the scalar one with tzcnt and blsr beats shuffling with AVX2, so AVX2 just uses that,
+    // AVX-512 has a real compress, so it gets its own. (see '__extract_primes_from_block_avx512()')
+    PRIME_GENERATOR_TARGET_AVX2
+    Prime_Generator_Internal u64 *__extract_primes_from_block_avx2(u64 *out, const u64 *is_not_prime_bits, u64 word_count, u64 block_start, const Prime_Generator_Wheel *wheel) {
+        return __extract_primes_from_block_scalar(out, is_not_prime_bits, word_count, block_start, wheel);
+    }
+#endif // PRIME_GENERATOR_DISPATCH
+
+static const Prime_Generator_Kernels prime_generator_kernels[PRIME_GENERATOR_ISA_COUNT] = {
+    // never used, AUTO gets turned into a real one.
+    [PRIME_GENERATOR_ISA_AUTO]     = { __pre_sieve_block_baseline, __cross_off_baseline, __count_primes_in_block_baseline, __extract_primes_from_block_baseline },
+    [PRIME_GENERATOR_ISA_BASELINE] = { __pre_sieve_block_baseline, __cross_off_baseline, __count_primes_in_block_baseline, __extract_primes_from_block_baseline },
+#if PRIME_GENERATOR_DISPATCH
+    [PRIME_GENERATOR_ISA_AVX2]     = { __pre_sieve_block_avx2,     __cross_off_avx2,     __count_primes_in_block_avx2,     __extract_primes_from_block_avx2   },
+    [PRIME_GENERATOR_ISA_AVX512]   = { __pre_sieve_block_avx512,   __cross_off_avx512,   __count_primes_in_block_avx512,   __extract_primes_from_block_avx512 },
+#else
+    [PRIME_GENERATOR_ISA_AVX2]     = { __pre_sieve_block_baseline, __cross_off_baseline, __count_primes_in_block_baseline, __extract_primes_from_block_baseline },
+    [PRIME_GENERATOR_ISA_AVX512]   = { __pre_sieve_block_baseline, __cross_off_baseline, __count_primes_in_block_baseline, __extract_primes_from_block_baseline },
+#endif // PRIME_GENERATOR_DISPATCH
+};
+
+// sieve the block at 'sieve->block_start', then move onto the next one.
+//
+// call '__sieve_add_primes()' first, so all the primes that hit this block are in.
+Prime_Generator_Internal void __sieve_block(Prime_Generator_Sieve *sieve, const Prime_Generator_Wheel *wheel, u64 *is_not_prime_bits) {
+    const Prime_Generator_Kernels *kernels = &prime_generator_kernels[wheel->isa];
+
+    // the small primes are allready crossed off in the pattern.
+    kernels->pre_sieve(wheel, is_not_prime_bits, wheel->bits_per_block / 64, sieve->block_start);
+    kernels->cross_off(sieve, wheel, is_not_prime_bits);
+
+    sieve->block_start += wheel->numbers_per_block;
+}
+
+
+// start the sieve over at a new block, keeps the memory around.
+Prime_Generator_Internal void __reset_sieve(Prime_Generator_Sieve *sieve, u64 block_start) {
+    Prime_Generator_Bucket_Sieve *bucket_sieve = &sieve->bucket_sieve;
+
+    // throw all the buckets on the free list.
+    for (u64 i = 0; i < bucket_sieve->ring_size; i++) {
+        Prime_Generator_Bucket *bucket = bucket_sieve->ring[i];
+        while (bucket) {
+            Prime_Generator_Bucket *next = bucket->next;
+            bucket->next = bucket_sieve->free_buckets;
+            bucket_sieve->free_buckets = bucket;
+            bucket = next;
+        }
+        bucket_sieve->ring[i] = NULL;
+    }
+    bucket_sieve->block_number = 0;
+
+    sieve->sieving_prime_count = 0;
+    sieve->next_prime_index    = 0;
+    sieve->block_start         = block_start;
+}
+
+Prime_Generator_Internal void __free_sieve(Prime_Generator_Sieve *sieve) {
+    PRIME_GENERATOR_FREE(sieve->sieving_primes, sieve->sieving_prime_capacity * sizeof(Prime_Generator_Sieving_Prime));
+    __free_bucket_sieve(&sieve->bucket_sieve);
+
+    PRIME_GENERATOR_MEM_ZERO(sieve, sizeof(*sieve));
+}
+
+
+
+/////////////////////////////////////////////////
+//             COMPRESSED STORAGE
+/////////////////////////////////////////////////
+
+// primes per chunk, more is smaller but slower to look things up in.
+#ifndef PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE
+    #define PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE    256
+#endif // PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE
+
+// a gap of 0 cant happen, so it means the real gap is in the next 2 bytes.
+#define PRIME_GENERATOR_GAP_ESCAPE    0
+
+
+// make room for 'prime_count' more primes, (assuming they all fit in 1 byte)
+Prime_Generator_Internal bool __compressed_primes_reserve(Prime_Generator_Compressed_Primes *compressed, u64 prime_count) {
+    u64 chunks_needed = (compressed->count + prime_count + PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE - 1) / PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE;
+    if (chunks_needed > compressed->chunk_capacity) {
+        u64 new_capacity = compressed->chunk_capacity * 2;
+        if (new_capacity < chunks_needed) new_capacity = chunks_needed;
+
+        Prime_Generator_Compressed_Chunk *new_chunks = PRIME_GENERATOR_REALLOC(
+            compressed->chunks,
+            compressed->chunk_capacity * sizeof(Prime_Generator_Compressed_Chunk),
+            new_capacity * sizeof(Prime_Generator_Compressed_Chunk)
+        );
+        if (!new_chunks) {
+            PRIME_GENERATOR_ASSERT(new_chunks && "You ran out of memory, how many primes did you just try to make?");
+            return false;
+        }
+        compressed->chunks         = new_chunks;
+        compressed->chunk_capacity = new_capacity;
+    }
+
+    // + 3, so one escaped gap always fits.
+    u64 gaps_needed = compressed->gap_count + prime_count + 3;
+    if (gaps_needed > compressed->gap_capacity) {
+        u64 new_capacity = compressed->gap_capacity * 2;
+        if (new_capacity < gaps_needed) new_capacity = gaps_needed;
+
+        uint8_t *new_gaps = PRIME_GENERATOR_REALLOC(compressed->gaps, compressed->gap_capacity, new_capacity);
+        if (!new_gaps) {
+            PRIME_GENERATOR_ASSERT(new_gaps && "You ran out of memory, how many primes did you just try to make?");
+            return false;
+        }
+        compressed->gaps         = new_gaps;
+        compressed->gap_capacity = new_capacity;
+    }
+
+    return true;
+}
+
+// add primes to the end, they have to be bigger than the ones allready in there.
+Prime_Generator_Internal void __compressed_primes_append(Prime_Generator_Compressed_Primes *compressed, const u64 *primes, u64 prime_count) {
+    if (!__compressed_primes_reserve(compressed, prime_count)) return;
+
+    for (u64 i = 0; i < prime_count; i++) {
+        u64 prime = primes[i];
+
+        // start a new chunk.
+        if (compressed->count % PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE == 0) {
+            compressed->chunks[compressed->chunk_count++] = (Prime_Generator_Compressed_Chunk){
+                .base       = prime,
+                .gap_offset = compressed->gap_count,
+            };
+        } else {
+            u64 gap = prime - compressed->last_prime;
+
+            if (gap < 256) {
+                compressed->gaps[compressed->gap_count++] = (uint8_t) gap;
+            } else {
+                if (gap >= (1 << 16)) {
+                    PRIME_GENERATOR_ASSERT(gap < (1 << 16) && "a gap between primes this big is not possible below 2^64, this is a bug.");
+                    return;
+                }
+                // the rare ones, make sure there is room for them.
+                if (!__compressed_primes_reserve(compressed, prime_count - i)) return;
+
+                compressed->gaps[compressed->gap_count++] = PRIME_GENERATOR_GAP_ESCAPE;
+                compressed->gaps[compressed->gap_count++] = (uint8_t)(gap);
+                compressed->gaps[compressed->gap_count++] = (uint8_t)(gap >> 8);
+            }
+        }
+
+        compressed->last_prime = prime;
+        compressed->count += 1;
+    }
+}
+
+// read a gap, and move past it.
+Prime_Generator_Internal u64 __compressed_primes_read_gap(const uint8_t **gaps) {
+    const uint8_t *gap = *gaps;
+    if (gap[0] != PRIME_GENERATOR_GAP_ESCAPE) {
+        *gaps = gap + 1;
+        return gap[0];
+    }
+    *gaps = gap + 3;
+    return (u64) gap[1] | ((u64) gap[2] << 8);
+}
+
+// decode 'count' primes starting at 'first_index' (0 indexed) into 'out'
+Prime_Generator_Internal void __compressed_primes_decode(const Prime_Generator_Compressed_Primes *compressed, u64 first_index, u64 count, u64 *out) {
+    if (count == 0) return;
+    if (first_index + count > compressed->count) {
+        PRIME_GENERATOR_ASSERT(first_index + count <= compressed->count && "decoding past the last prime, this is a bug.");
+        return;
+    }
+
+    u64 chunk = first_index / PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE;
+    u64 prime = compressed->chunks[chunk].base;
+    const uint8_t *gaps = &compressed->gaps[compressed->chunks[chunk].gap_offset];
+
+    // walk upto the first one.
+    for (u64 i = 0; i < first_index % PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE; i++) prime += __compressed_primes_read_gap(&gaps);
+    out[0] = prime;
+
+    u64 index = first_index;
+    for (u64 i = 1; i < count; i++) {
+        index += 1;
+        if (index % PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE == 0) {
+            // the gaps of one chunk run straight into the next, but the first prime is not a gap.
+            chunk += 1;
+            prime = compressed->chunks[chunk].base;
+        } else {
+            prime += __compressed_primes_read_gap(&gaps);
+        }
+        out[i] = prime;
+    }
+}
+
+Prime_Generator_Internal void __free_compressed_primes(Prime_Generator_Compressed_Primes *compressed) {
+    PRIME_GENERATOR_FREE(compressed->chunks, compressed->chunk_capacity * sizeof(Prime_Generator_Compressed_Chunk));
+    PRIME_GENERATOR_FREE(compressed->gaps,   compressed->gap_capacity);
+    PRIME_GENERATOR_MEM_ZERO(compressed, sizeof(*compressed));
+}
+
+
+
+/////////////////////////////////////////////////
+//              CHUNKED STORAGE
+/////////////////////////////////////////////////
+
+// how many primes chunk 'k' holds.
+#define PRIME_GENERATOR_CHUNK_CAPACITY(k)    ((u64) PRIME_GENERATOR_FIRST_CHUNK_SIZE << (k))
+
+// which chunk the prime at 'index' is in, and where in it.
+//
+// chunk 'k' starts at 'FIRST * (2^k - 1)', so its just the highest bit of 'index / FIRST + 1'
+Prime_Generator_Internal void __chunked_primes_locate(u64 index, u64 *chunk, u64 *offset) {
+    u64 k = 63 - PRIME_GENERATOR_CLZ(index / PRIME_GENERATOR_FIRST_CHUNK_SIZE + 1);
+    *chunk  = k;
+    *offset = index - PRIME_GENERATOR_FIRST_CHUNK_SIZE * ((1ULL << k) - 1);
+}
+
+// add primes to the end, a new chunk is only made when the last one is full, nothing ever gets copied.
+Prime_Generator_Internal void __chunked_primes_append(Prime_Generator_Chunked_Primes *chunked, const u64 *primes, u64 prime_count) {
+    while (prime_count) {
+        u64 chunk, offset;
+        __chunked_primes_locate(chunked->count, &chunk, &offset);
+
+        if (chunk >= chunked->chunk_count) {
+            if (chunk >= PRIME_GENERATOR_MAX_CHUNKS) {
+                PRIME_GENERATOR_ASSERT(chunk < PRIME_GENERATOR_MAX_CHUNKS && "more primes than a u64 can count, this is a bug.");
+                return;
+            }
+            u64 *new_chunk = PRIME_GENERATOR_REALLOC(NULL, 0, PRIME_GENERATOR_CHUNK_CAPACITY(chunk) * sizeof(u64));
+            if (!new_chunk) {
+                PRIME_GENERATOR_ASSERT(new_chunk && "You ran out of memory, how many primes did you just try to make?");
+                return;
+            }
+            chunked->chunks[chunk] = new_chunk;
+            chunked->chunk_count   = chunk + 1;
+        }
+
+        u64 room  = PRIME_GENERATOR_CHUNK_CAPACITY(chunk) - offset;
+        u64 count = (prime_count < room) ? prime_count : room;
+        PRIME_GENERATOR_MEM_COPY(&chunked->chunks[chunk][offset], primes, count * sizeof(u64));
+
+        chunked->count += count;
+        primes         += count;
+        prime_count    -= count;
+    }
+}
+
+// decode 'count' primes starting at 'first_index' (0 indexed) into 'out', its just copying out of the chunks.
+Prime_Generator_Internal void __chunked_primes_decode(const Prime_Generator_Chunked_Primes *chunked, u64 first_index, u64 count, u64 *out) {
+    while (count) {
+        u64 chunk, offset;
+        __chunked_primes_locate(first_index, &chunk, &offset);
+
+        u64 room  = PRIME_GENERATOR_CHUNK_CAPACITY(chunk) - offset;
+        u64 taken = (count < room) ? count : room;
+        PRIME_GENERATOR_MEM_COPY(out, &chunked->chunks[chunk][offset], taken * sizeof(u64));
+
+        first_index += taken;
+        out         += taken;
+        count       -= taken;
+    }
+}
+
+Prime_Generator_Internal void __free_chunked_primes(Prime_Generator_Chunked_Primes *chunked) {
+    for (u64 k = 0; k < chunked->chunk_count; k++) {
+        PRIME_GENERATOR_FREE(chunked->chunks[k], PRIME_GENERATOR_CHUNK_CAPACITY(k) * sizeof(u64));
+    }
+    PRIME_GENERATOR_MEM_ZERO(chunked, sizeof(*chunked));
+}
+
+
+
+/////////////////////////////////////////////////
+//                 CACHE FILES
+/////////////////////////////////////////////////
+
+#define PRIME_GENERATOR_CACHE_MAGIC              "PRIMEGEN"
+// the primes as u64's, from 'save_prime_generator()'
+#define PRIME_GENERATOR_CACHE_VERSION            1
+// the primes compressed, with an index, from 'export_prime_generator()'
+#define PRIME_GENERATOR_CACHE_VERSION_INDEXED    2
+
+// how many primes the cache functions decode at a time, for the storages that need it.
+#define PRIME_GENERATOR_CACHE_DECODE_SIZE        4096
+
+// the start of every cache file, for PRIME_GENERATOR_CACHE_VERSION the primes come right after it, 'count' u64's.
+//
+// everything is in the byte order of the machine that wrote it, a file from the other
+// byte order has a version of 2^56, so it just dosent load.
+typedef struct Prime_Generator_Cache_Header {
+    char magic[8];
+    u64 version;
+    // how many primes are in the file.
+    u64 count;
+    // every prime under this is in the file.
+    u64 last_prime_checked;
+} Prime_Generator_Cache_Header;
+
+// so the primes after it are lined up.
+PRIME_GENERATOR_STATIC_ASSERT(sizeof(Prime_Generator_Cache_Header) == 4 * sizeof(u64), "the cache header should not have any padding");
+
+// the whole header of a PRIME_GENERATOR_CACHE_VERSION_INDEXED file.
+//
+// its PRIME_GENERATOR_STORAGE_COMPRESSED laid out flat, the gaps right after the header, then the
+// chunks, (the checkpoints, the first prime of every chunk, and where its gaps start) so finding
+// any prime only decodes 1 chunk, and only the pages with that chunk ever get read off the disk.
+typedef struct Prime_Generator_Index_Header {
+    Prime_Generator_Cache_Header cache;
+    // primes per chunk, has to be PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE to load.
+    u64 chunk_size;
+    u64 chunk_count;
+    // where the chunks start, after the gaps, lined up to 8 bytes.
+    u64 chunk_offset;
+    u64 gap_count;
+} Prime_Generator_Index_Header;
+
+PRIME_GENERATOR_STATIC_ASSERT(sizeof(Prime_Generator_Index_Header) == 8 * sizeof(u64), "the index header should not have any padding");
+
+
+Prime_Generator_Internal void __free_mapped_primes(Prime_Generator_Mapped_Primes *mapped) {
+    #ifndef PRIME_GENERATOR_NO_FILES
+        if (mapped->base) munmap(mapped->base, mapped->size);
+    #endif // PRIME_GENERATOR_NO_FILES
+
+    PRIME_GENERATOR_MEM_ZERO(mapped, sizeof(*mapped));
+}
+
+// decode 'count' primes starting at 'first_index' (0 indexed) out of a mapped file into 'out'
+Prime_Generator_Internal void __mapped_primes_decode(const Prime_Generator_Mapped_Primes *mapped, u64 first_index, u64 count, u64 *out) {
+    if (mapped->items) PRIME_GENERATOR_MEM_COPY(out, &mapped->items[first_index], count * sizeof(u64));
+    else               __compressed_primes_decode(&mapped->compressed, first_index, count, out);
+}
+
+// map a cache file in, and make sure it looks right, on false, nothing is mapped.
+//
+// a missing or broken file is not a bug, (its probably just the first run) so no asserts.
+Prime_Generator_Internal bool __map_prime_cache(const char *path, Prime_Generator_Mapped_Primes *mapped, u64 *last_prime_checked) {
+    #ifdef PRIME_GENERATOR_NO_FILES
+        (void) path; (void) mapped; (void) last_prime_checked;
+        return false;
+    #else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat file_info;
+        if (fstat(fd, &file_info) != 0 || (u64) file_info.st_size < sizeof(Prime_Generator_Cache_Header)) {
+            close(fd);
+            return false;
+        }
+
+        u64 size   = (u64) file_info.st_size;
+        void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        // the mapping keeps the file around, we dont need the fd anymore.
+        close(fd);
+        if (base == MAP_FAILED) return false;
+
+        const Prime_Generator_Cache_Header *header = base;
+        *mapped = (Prime_Generator_Mapped_Primes){ .base = base, .size = size, .count = header->count };
+
+        bool looks_right = memcmp(header->magic, PRIME_GENERATOR_CACHE_MAGIC, sizeof(header->magic)) == 0
+                        && header->count != 0
+                        && header->last_prime_checked <= (1ULL << 60);
+
+        if (looks_right && header->version == PRIME_GENERATOR_CACHE_VERSION) {
+            looks_right = header->count <= (size - sizeof(*header)) / sizeof(u64)
+                       && size == sizeof(*header) + header->count * sizeof(u64);
+
+            mapped->items = (const u64 *) (header + 1);
+
+        } else if (looks_right && header->version == PRIME_GENERATOR_CACHE_VERSION_INDEXED && size >= sizeof(Prime_Generator_Index_Header)) {
+            const Prime_Generator_Index_Header *index = base;
+            u64 chunk_size = sizeof(Prime_Generator_Compressed_Chunk);
+
+            looks_right = index->chunk_size   == PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE
+                       && index->chunk_count  == (header->count + PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE - 1) / PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE
+                       && index->chunk_offset %  sizeof(u64) == 0
+                       && index->gap_count    <= size
+                       && index->chunk_offset >= sizeof(*index) + index->gap_count
+                       && index->chunk_offset <= size
+                       && (size - index->chunk_offset) == index->chunk_count * chunk_size;
+
+            // the compressed storage can read it as is, its never added to, so the casts are fine.
+            mapped->compressed = (Prime_Generator_Compressed_Primes){
+                .chunks      = (Prime_Generator_Compressed_Chunk *) ((uint8_t *) base + index->chunk_offset),
+                .chunk_count = index->chunk_count,
+                .gaps        = (uint8_t *) (index + 1),
+                .gap_count   = index->gap_count,
+                .count       = header->count,
+            };
+            // the decoder trusts the chunks, so make sure they make sense, its only 1 in 256 of the primes.
+            //
+            // every chunk has to start inside the gaps, after the one before it, with room
+            // for at least a byte per gap, and its first prime has to be bigger.
+            const Prime_Generator_Compressed_Chunk *chunks = mapped->compressed.chunks;
+            for (u64 i = 0; looks_right && i < index->chunk_count; i++) {
+                u64 gaps_in_chunk = PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE - 1;
+                if (i == index->chunk_count - 1) gaps_in_chunk = header->count - i * PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE - 1;
+
+                u64 gap_end = (i + 1 < index->chunk_count) ? chunks[i+1].gap_offset : index->gap_count;
+
+                looks_right = chunks[i].gap_offset <= gap_end
+                           && gap_end <= index->gap_count
+                           && gap_end - chunks[i].gap_offset >= gaps_in_chunk;
+                if (i == 0) looks_right = looks_right && chunks[i].gap_offset == 0;
+                else        looks_right = looks_right && chunks[i].base > chunks[i-1].base;
+            }
+
+            // the last chunk is the one most likely to be cut off, so walk its gaps, they have to end right at the end.
+            if (looks_right) {
+                const Prime_Generator_Compressed_Chunk *last = &chunks[index->chunk_count-1];
+                const uint8_t *gaps     = mapped->compressed.gaps + last->gap_offset;
+                const uint8_t *gaps_end = mapped->compressed.gaps + index->gap_count;
+
+                u64 gaps_left = header->count - (index->chunk_count - 1) * PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE - 1;
+                for (; looks_right && gaps_left; gaps_left--) {
+                    looks_right = gaps < gaps_end && (gaps[0] != PRIME_GENERATOR_GAP_ESCAPE || gaps_end - gaps >= 3);
+                    if (looks_right) __compressed_primes_read_gap(&gaps);
+                }
+                looks_right = looks_right && gaps == gaps_end;
+            }
+
+        } else {
+            looks_right = false;
+        }
+
+        // just the ends, checking every prime would take as long as making them.
+        u64 first_prime = 0, last_prime = 0;
+        if (looks_right) {
+            __mapped_primes_decode(mapped, 0, 1, &first_prime);
+            __mapped_primes_decode(mapped, header->count-1, 1, &last_prime);
+        }
+        looks_right = looks_right && first_prime == 2 && last_prime < header->last_prime_checked;
+
+        if (!looks_right) {
+            munmap(base, size);
+            PRIME_GENERATOR_MEM_ZERO(mapped, sizeof(*mapped));
+            return false;
+        }
+
+        *last_prime_checked = header->last_prime_checked;
+        return true;
+    #endif // PRIME_GENERATOR_NO_FILES
+}
+
+
+
+/////////////////////////////////////////////////
+//                  STORAGE
+/////////////////////////////////////////////////
+
+// pi(2^32), PRIME_GENERATOR_STORAGE_U32 holds this many primes before it switches to u64's.
+#define PRIME_GENERATOR_PRIMES_UNDER_2_32    203280221ULL
+
+
+// how many primes the generator has, no matter how they are stored.
+Prime_Generator_Internal u64 __prime_generator_count(const Prime_Generator *prime_generator) {
+    switch (prime_generator->storage) {
+        case PRIME_GENERATOR_STORAGE_COMPRESSED: return prime_generator->compressed.count;
+        case PRIME_GENERATOR_STORAGE_U32:        return prime_generator->u32_primes.count + prime_generator->inner_prime_array.count;
+        case PRIME_GENERATOR_STORAGE_MAPPED:     return prime_generator->mapped.count     + prime_generator->inner_prime_array.count;
+        case PRIME_GENERATOR_STORAGE_CHUNKED:    return prime_generator->chunked.count;
+        default:                                 return prime_generator->inner_prime_array.count;
+    }
+}
+
+// decode 'count' primes starting at 'first_index' (0 indexed) into 'out', they have to be generated allready.
+Prime_Generator_Internal void __prime_generator_decode(const Prime_Generator *prime_generator, u64 first_index, u64 count, u64 *out) {
+    switch (prime_generator->storage) {
+        case PRIME_GENERATOR_STORAGE_COMPRESSED: {
+            __compressed_primes_decode(&prime_generator->compressed, first_index, count, out);
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_U32: {
+            const Prime_Array_U32 *small = &prime_generator->u32_primes;
+            u64 i = 0;
+            for (; i < count && first_index + i < small->count; i++) out[i] = small->items[first_index + i];
+            for (; i < count; i++)                                   out[i] = prime_generator->inner_prime_array.items[first_index + i - small->count];
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_MAPPED: {
+            const Prime_Generator_Mapped_Primes *mapped = &prime_generator->mapped;
+            u64 from_file = (first_index < mapped->count) ? mapped->count - first_index : 0;
+            if (from_file > count) from_file = count;
+
+            __mapped_primes_decode(mapped, first_index, from_file, out);
+            for (u64 i = from_file; i < count; i++) out[i] = prime_generator->inner_prime_array.items[first_index + i - mapped->count];
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_CHUNKED: {
+            __chunked_primes_decode(&prime_generator->chunked, first_index, count, out);
+        } break;
+
+        default: {
+            PRIME_GENERATOR_MEM_COPY(out, &prime_generator->inner_prime_array.items[first_index], count * sizeof(u64));
+        } break;
+    }
+}
+
+// the prime at 'index', (0 indexed) it has to be generated allready.
+Prime_Generator_Internal u64 __prime_generator_get(const Prime_Generator *prime_generator, u64 index) {
+    if (prime_generator->storage == PRIME_GENERATOR_STORAGE_U64) return prime_generator->inner_prime_array.items[index];
+
+    u64 prime = 0;
+    __prime_generator_decode(prime_generator, index, 1, &prime);
+    return prime;
+}
+
+// put freshly made primes into the generator, they go after the ones it has.
+Prime_Generator_Internal void __prime_generator_store_primes(Prime_Generator *prime_generator, const u64 *primes, u64 prime_count) {
+    switch (prime_generator->storage) {
+        case PRIME_GENERATOR_STORAGE_COMPRESSED: {
+            __compressed_primes_append(&prime_generator->compressed, primes, prime_count);
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_U32: {
+            // once one prime is to big, the rest are too.
+            u64 small_count = 0;
+            if (prime_generator->inner_prime_array.count == 0) {
+                while (small_count < prime_count && primes[small_count] < (1ULL << 32)) small_count += 1;
+            }
+
+            Prime_Array_U32 *small = &prime_generator->u32_primes;
+            if (!Prime_Array_U32_Reserve(small, small->count + small_count)) return;
+            for (u64 i = 0; i < small_count; i++) small->items[small->count + i] = (uint32_t) primes[i];
+            small->count += small_count;
+
+            Prime_Array_Append_Many(&prime_generator->inner_prime_array, primes + small_count, prime_count - small_count);
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_CHUNKED: {
+            __chunked_primes_append(&prime_generator->chunked, primes, prime_count);
+        } break;
+
+        default: {
+            Prime_Array_Append_Many(&prime_generator->inner_prime_array, primes, prime_count);
+        } break;
+    }
+}
+
+// the smallest the sieving prime table starts at, so it dosent grow a bunch of times at the start.
+#define PRIME_GENERATOR_MIN_SIEVING_PRIME_LIMIT    (1 << 16)
+
+// the primes to sieve with, (from 2) every prime upto 'upto' is in there, and maybe some more.
+//
+// it grows itself, from nothing, so it never needs the generators primes.
+// the pointer is only good untill the next time you call this.
+Prime_Generator_Internal const u64 *__prime_generator_sieving_primes(Prime_Generator *prime_generator, u64 upto, u64 *prime_count) {
+    Prime_Array *table = &prime_generator->sieving_prime_table;
+
+    if (upto >= prime_generator->sieving_prime_limit) {
+        // at least double it, so the sieving primes only ever cost about 2 sieves upto sqrt(n)
+        u64 new_limit = prime_generator->sieving_prime_limit * 2;
+        if (new_limit < upto + 1)                                new_limit = upto + 1;
+        if (new_limit < PRIME_GENERATOR_MIN_SIEVING_PRIME_LIMIT) new_limit = PRIME_GENERATOR_MIN_SIEVING_PRIME_LIMIT;
+
+        // these are always way smaller than the primes we are making, so just start over.
+        table->count = 0;
+        get_primes_upto_number(new_limit - 1, table);
+        prime_generator->sieving_prime_limit = new_limit;
+    }
+
+    *prime_count = table->count;
+    return table->items;
+}
+
+
+
+
+/////////////////////////////////////////////////
+//                  BITMAP
+/////////////////////////////////////////////////
+
+// how many words of bitmap it takes to cover the numbers under 'until'
+Prime_Generator_Internal u64 __bitmap_word_count(const Prime_Generator_Wheel *wheel, u64 until) {
+    u64 turns = (until + wheel->modulus - 1) / wheel->modulus;
+    return (turns * wheel->residue_count + 63) / 64;
+}
+
+// make sure the bitmap can hold every number under 'until', dose not change count.
+Prime_Generator_Internal bool __prime_generator_reserve_bitmap(Prime_Generator *prime_generator, u64 until) {
+    return Prime_Array_Reserve(&prime_generator->bitmap, __bitmap_word_count(prime_generator->wheel, until));
+}
+
+// set the bits for the primes of the first block, (it dosent have sieve bits, its made with 'get_primes_upto_number()')
+Prime_Generator_Internal void __bitmap_add_primes(const Prime_Generator_Wheel *wheel, u64 *bitmap, const u64 *primes, u64 prime_count) {
+    for (u64 i = 0; i < prime_count; i++) {
+        u64 prime = primes[i];
+        // the primes in the wheel dont have a bit.
+        if (wheel->residue_index[prime % wheel->modulus] == PRIME_GENERATOR_NOT_ON_WHEEL) continue;
+
+        u64 bit = (prime / wheel->modulus) * wheel->residue_count + wheel->residue_index[prime % wheel->modulus];
+        bitmap[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+// copy a sieved block into the bitmap, the blocks after the first one always start on a whole word.
+Prime_Generator_Internal void __bitmap_add_block(const Prime_Generator_Wheel *wheel, u64 *bitmap, const u64 *is_not_prime_bits, u64 block_start) {
+    u64 *words = &bitmap[(block_start / wheel->modulus) * wheel->residue_count / 64];
+    for (u64 i = 0; i < wheel->bits_per_block / 64; i++) words[i] = ~is_not_prime_bits[i];
+}
+
+
+
+// pull the primes out of a sieved block that starts at 'block_start', and add them to 'result'
+//
+// the primes are counted first, so the array only has to be checked (and grown) once.
+Prime_Generator_Internal u64 __extract_primes(const Prime_Generator_Wheel *wheel, Prime_Array *result, const u64 *is_not_prime_bits, u64 block_start) {
+    const Prime_Generator_Kernels *kernels = &prime_generator_kernels[wheel->isa];
+
+    u64 word_count  = wheel->bits_per_block / 64;
+    u64 prime_count = kernels->count(is_not_prime_bits, word_count);
+
+    if (!Prime_Array_Reserve(result, result->count + prime_count + PRIME_GENERATOR_EXTRACT_SLACK)) return 0;
+    u64 *out = &result->items[result->count];
+
+    u64 *end = kernels->extract(out, is_not_prime_bits, word_count, block_start, wheel);
+
+    if ((u64)(end - out) != prime_count) {
+        PRIME_GENERATOR_ASSERT((u64)(end - out) == prime_count && "extracted a different number of primes than we counted, this is a bug.");
+        return 0;
+    }
+
+    result->count += prime_count;
+    return prime_count;
+}
+
+
+
+// private function, generates the next block of primes.
+//
+// returns the number of added primes, maybe that will be useful someday.
+Prime_Generator_Internal u64 __generate_prime_block(Prime_Generator *prime_generator) {
+    if (!__prime_generator_wheel_init(prime_generator)) return 0;
+
+    const Prime_Generator_Wheel *wheel = prime_generator->wheel;
+
+    if (prime_generator->last_prime_checked % wheel->modulus != 0) {
+        PRIME_GENERATOR_ASSERT(prime_generator->last_prime_checked % wheel->modulus == 0 && "dont mess with my innards, last_prime_checked was not a multiple of the wheel");
+        return 0;
+    }
+
+    if (prime_generator->last_prime_checked >= (1UL << 60)) {
+        PRIME_GENERATOR_ASSERT(false && "This is getting a little out of hand.");
+        return 0;
+    }
+
+    if (prime_generator->last_prime_checked == 0) {
+        // we special case 0, because it has 2 as the first prime,
+        // and we can do some optimizations knowing we have 2.
+        //
+        // also knowing all numbers in the block cannot effect the block itself is good.
+        //
+        // so we just use a simple Sieve, im a little
+        // worried this might be slow if we crank the block size
+        Prime_Array *first_primes = (prime_generator->storage != PRIME_GENERATOR_STORAGE_U64) ? &prime_generator->staging : &prime_generator->inner_prime_array;
+        get_primes_upto_number(wheel->first_block_end, first_primes);
+
+        if (prime_generator->keep_bitmap) {
+            Prime_Array *bitmap = &prime_generator->bitmap;
+            if (!__prime_generator_reserve_bitmap(prime_generator, wheel->first_block_end)) return 0;
+
+            bitmap->count = __bitmap_word_count(wheel, wheel->first_block_end);
+            PRIME_GENERATOR_MEM_ZERO(bitmap->items, bitmap->count * sizeof(u64));
+            __bitmap_add_primes(wheel, bitmap->items, first_primes->items, first_primes->count);
+        }
+
+        if (prime_generator->storage != PRIME_GENERATOR_STORAGE_U64) {
+            __prime_generator_store_primes(prime_generator, first_primes->items, first_primes->count);
+            first_primes->count = 0;
+        }
+        prime_generator->last_prime_checked = wheel->first_block_end;
+        prime_generator->sieve.block_start  = wheel->first_block_end;
+        return __prime_generator_count(prime_generator);
+    }
+
+    Prime_Generator_Sieve *sieve = &prime_generator->sieve;
+    if (sieve->block_start != prime_generator->last_prime_checked) {
+        PRIME_GENERATOR_ASSERT(sieve->block_start == prime_generator->last_prime_checked && "dont mess with my innards, the sieve is out of sync");
+        return 0;
+    }
+
+    const u64 block_start = prime_generator->last_prime_checked;
+    const u64 block_end   = block_start + wheel->numbers_per_block;
+
+
+    // only numbers coprime to the wheel have a cell, (for the odd only layout, thats the odd numbers)
+    //
+    // bit 'i' is set if 'block_start + (i / R) * modulus + residues[i % R]' is not a prime.
+    u64 is_not_prime_bits[PRIME_GENERATOR_BLOCK_WORDS];
+
+    u64 sieving_prime_count;
+    const u64 *sieving_primes = __prime_generator_sieving_primes(prime_generator, int_sqrt(block_end), &sieving_prime_count);
+
+    // we *know* that we have 2 so lets do a little optimization.
+    if (sieving_prime_count == 0 || sieving_primes[0] != 2) {
+        PRIME_GENERATOR_ASSERT(sieving_prime_count != 0 && sieving_primes[0] == 2);
+        return 0;
+    }
+
+    __sieve_add_primes(sieve, wheel, sieving_primes, sieving_prime_count, block_end);
+    __sieve_block(sieve, wheel, is_not_prime_bits);
+
+    if (prime_generator->keep_bitmap) {
+        if (!__prime_generator_reserve_bitmap(prime_generator, block_end)) return 0;
+        __bitmap_add_block(wheel, prime_generator->bitmap.items, is_not_prime_bits, block_start);
+        prime_generator->bitmap.count = __bitmap_word_count(wheel, block_end);
+    }
+
+    // none of the numbers in this block can effect each other,
+    // (because we did a first block, and any numbers in here
+    // are bigger than the first block)
+    u64 number_of_primes_this_round;
+    if (prime_generator->storage != PRIME_GENERATOR_STORAGE_U64) {
+        Prime_Array *staging = &prime_generator->staging;
+        number_of_primes_this_round = __extract_primes(wheel, staging, is_not_prime_bits, block_start);
+        __prime_generator_store_primes(prime_generator, staging->items, staging->count);
+        staging->count = 0;
+    } else {
+        number_of_primes_this_round = __extract_primes(wheel, &prime_generator->inner_prime_array, is_not_prime_bits, block_start);
+    }
+
+    prime_generator->last_prime_checked = block_end;
+    return number_of_primes_this_round;
+}
+
+
+
+
+/////////////////////////////////////////////////
+//             PARALLEL GENERATION
+/////////////////////////////////////////////////
+
+// how many blocks each thread does before they all get put into the generator.
+//
+// bigger is less time waiting for threads to start, smaller is less memory.
+#ifndef PRIME_GENERATOR_BLOCKS_PER_THREAD
+    #define PRIME_GENERATOR_BLOCKS_PER_THREAD    64
+#endif // PRIME_GENERATOR_BLOCKS_PER_THREAD
+
+// the blocks are handed out in tasks of this many blocks,
+// a worker restarts its sieve for every task, so dont make this to small.
+#ifndef PRIME_GENERATOR_BLOCKS_PER_TASK
+    #define PRIME_GENERATOR_BLOCKS_PER_TASK    8
+#endif // PRIME_GENERATOR_BLOCKS_PER_TASK
+
+
+// a run of blocks, and the primes in them.
+struct Prime_Generator_Task {
+    Prime_Array primes;
+    // set once 'primes' is filled in, only touched under the commit lock.
+    bool done;
+};
+
+// everything the workers share while generating.
+typedef struct Prime_Generator_Round {
+    Prime_Generator *prime_generator;
+
+    const Prime_Generator_Wheel *wheel;
+
+    // the generators sieving prime table, nothing touches it while the workers are running,
+    // (the primes they make go somewhere else) so they can all just read it.
+    const u64 *sieving_primes;
+    u64 sieving_prime_count;
+
+    u64 first_block_start;
+    u64 block_count;
+    u64 task_count;
+
+    // the generators bitmap, allready big enough for the whole round,
+    // every block is its own words, so the workers can all write to it. NULL if we dont keep one.
+    u64 *bitmap;
+
+    #ifndef PRIME_GENERATOR_NO_THREADS
+        // the finished tasks get put into the generator in order,
+        // whoever finishes the next one in line does it.
+        pthread_mutex_t commit_lock;
+    #endif // PRIME_GENERATOR_NO_THREADS
+    u64 next_task_to_commit;
+} Prime_Generator_Round;
+
+struct Prime_Generator_Worker {
+    Prime_Generator_Round *round;
+    u64 worker_index;
+
+    // the tasks this worker still has to do, always a run of tasks [front, back)
+    //
+    // the worker takes from the front, and other workers steal from the back.
+    u64 front;
+    u64 back;
+    #ifndef PRIME_GENERATOR_NO_THREADS
+        pthread_mutex_t queue_lock;
+        pthread_t thread;
+        // if 'thread' really started, so we know to join it.
+        bool started;
+    #endif // PRIME_GENERATOR_NO_THREADS
+
+    // the workers own sieve, it starts over for every task.
+    Prime_Generator_Sieve sieve;
+};
+
+
+#ifndef PRIME_GENERATOR_NO_THREADS
+
+// take the next task from our own queue, or steal one from someone else.
+Prime_Generator_Internal bool __prime_generator_worker_next_task(Prime_Generator_Worker *worker, u64 *task_index) {
+    pthread_mutex_lock(&worker->queue_lock);
+    if (worker->front < worker->back) {
+        *task_index = worker->front++;
+        pthread_mutex_unlock(&worker->queue_lock);
+        return true;
+    }
+    pthread_mutex_unlock(&worker->queue_lock);
+
+    // nothing left for us, go steal from the back of someone elses queue.
+    Prime_Generator *prime_generator = worker->round->prime_generator;
+    u64 thread_count = prime_generator->thread_count;
+    for (u64 i = 1; i < thread_count; i++) {
+        Prime_Generator_Worker *victim = &prime_generator->workers[(worker->worker_index + i) % thread_count];
+
+        pthread_mutex_lock(&victim->queue_lock);
+        if (victim->front < victim->back) {
+            *task_index = --victim->back;
+            pthread_mutex_unlock(&victim->queue_lock);
+            return true;
+        }
+        pthread_mutex_unlock(&victim->queue_lock);
+    }
+
+    return false;
+}
+
+// mark a task as done, and put every finished task thats next in line into the generator.
+Prime_Generator_Internal void __prime_generator_commit_task(Prime_Generator_Round *round, u64 task_index) {
+    Prime_Generator *prime_generator = round->prime_generator;
+
+    pthread_mutex_lock(&round->commit_lock);
+
+    prime_generator->tasks[task_index].done = true;
+
+    while (round->next_task_to_commit < round->task_count && prime_generator->tasks[round->next_task_to_commit].done) {
+        Prime_Generator_Task *task = &prime_generator->tasks[round->next_task_to_commit];
+        __prime_generator_store_primes(prime_generator, task->primes.items, task->primes.count);
+
+        // keep the memory for next time.
+        task->primes.count = 0;
+        round->next_task_to_commit += 1;
+    }
+
+    pthread_mutex_unlock(&round->commit_lock);
+}
+
+Prime_Generator_Internal void *__prime_generator_worker_main(void *arg) {
+    Prime_Generator_Worker *worker = arg;
+    Prime_Generator_Round  *round  = worker->round;
+    const Prime_Generator_Wheel *wheel = round->wheel;
+
+    u64 is_not_prime_bits[PRIME_GENERATOR_BLOCK_WORDS];
+
+    u64 task_index;
+    while (__prime_generator_worker_next_task(worker, &task_index)) {
+        Prime_Generator_Task *task = &round->prime_generator->tasks[task_index];
+
+        u64 first_block = task_index * PRIME_GENERATOR_BLOCKS_PER_TASK;
+        u64 last_block  = first_block + PRIME_GENERATOR_BLOCKS_PER_TASK;
+        if (last_block > round->block_count) last_block = round->block_count;
+
+        __reset_sieve(&worker->sieve, round->first_block_start + first_block * wheel->numbers_per_block);
+
+        for (u64 i = first_block; i < last_block; i++) {
+            u64 block_start = worker->sieve.block_start;
+
+            __sieve_add_primes(&worker->sieve, wheel, round->sieving_primes, round->sieving_prime_count, block_start + wheel->numbers_per_block);
+            __sieve_block(&worker->sieve, wheel, is_not_prime_bits);
+            if (round->bitmap) __bitmap_add_block(wheel, round->bitmap, is_not_prime_bits, block_start);
+            __extract_primes(wheel, &task->primes, is_not_prime_bits, block_start);
+        }
+
+        __prime_generator_commit_task(round, task_index);
+    }
+
+    return NULL;
+}
+
+#endif // PRIME_GENERATOR_NO_THREADS
+
+
+// sieve the blocks upto 'until' (or a good chunk of them) on 'thread_count' threads.
+//
+// the blocks are split into tasks, each worker starts with a run of them,
+// and steals from the others when it runs out, so the fast ones dont wait
+// on the slow ones. the finished tasks go into the generator in order.
+//
+// returns false if its not worth it, and you should just do it one block at a time.
+Prime_Generator_Internal bool __generate_prime_blocks_in_parallel(Prime_Generator *prime_generator, u64 until) {
+    #ifdef PRIME_GENERATOR_NO_THREADS
+        (void) prime_generator; (void) until;
+        return false;
+    #else
+        u64 thread_count = prime_generator->thread_count;
+        if (thread_count <= 1) return false;
+
+        // the first block is special, let '__generate_prime_block()' do it.
+        if (prime_generator->last_prime_checked == 0) return false;
+        if (!__prime_generator_wheel_init(prime_generator)) return false;
+
+        const Prime_Generator_Wheel *wheel = prime_generator->wheel;
+        u64 block_start = prime_generator->last_prime_checked;
+        if (until <= block_start) return false;
+
+        u64 blocks_needed = (until - block_start + wheel->numbers_per_block - 1) / wheel->numbers_per_block;
+        if (blocks_needed > thread_count * PRIME_GENERATOR_BLOCKS_PER_THREAD) {
+            blocks_needed = thread_count * PRIME_GENERATOR_BLOCKS_PER_THREAD;
+        }
+
+        // the sieving prime table grows itself, (see '__prime_generator_sieving_primes()')
+        // so the only limit is the same one '__generate_prime_block()' has.
+        while (blocks_needed && block_start + blocks_needed * wheel->numbers_per_block > (1UL << 60)) blocks_needed -= 1;
+
+        u64 task_count = (blocks_needed + PRIME_GENERATOR_BLOCKS_PER_TASK - 1) / PRIME_GENERATOR_BLOCKS_PER_TASK;
+        // not enough to go around.
+        if (task_count < thread_count * 2) return false;
+
+        u64 round_end = block_start + blocks_needed * wheel->numbers_per_block;
+
+        // make the workers.
+        if (prime_generator->worker_count < thread_count) {
+            Prime_Generator_Worker *new_workers = PRIME_GENERATOR_REALLOC(
+                prime_generator->workers,
+                prime_generator->worker_count * sizeof(Prime_Generator_Worker),
+                thread_count * sizeof(Prime_Generator_Worker)
+            );
+            if (!new_workers) {
+                PRIME_GENERATOR_ASSERT(new_workers && "You ran out of memory, how many threads did you ask for?");
+                return false;
+            }
+            PRIME_GENERATOR_MEM_ZERO(new_workers + prime_generator->worker_count, (thread_count - prime_generator->worker_count) * sizeof(Prime_Generator_Worker));
+
+            prime_generator->workers      = new_workers;
+            prime_generator->worker_count = thread_count;
+        }
+
+        // and the tasks.
+        if (prime_generator->task_capacity < task_count) {
+            Prime_Generator_Task *new_tasks = PRIME_GENERATOR_REALLOC(
+                prime_generator->tasks,
+                prime_generator->task_capacity * sizeof(Prime_Generator_Task),
+                task_count * sizeof(Prime_Generator_Task)
+            );
+            if (!new_tasks) {
+                PRIME_GENERATOR_ASSERT(new_tasks && "You ran out of memory, how many primes did you just try to make?");
+                return false;
+            }
+            PRIME_GENERATOR_MEM_ZERO(new_tasks + prime_generator->task_capacity, (task_count - prime_generator->task_capacity) * sizeof(Prime_Generator_Task));
+
+            prime_generator->tasks         = new_tasks;
+            prime_generator->task_capacity = task_count;
+        }
+        for (u64 i = 0; i < task_count; i++) prime_generator->tasks[i].done = false;
+
+        // all the sieving primes the round needs, it wont grow while the workers are running.
+        u64 sieving_prime_count;
+        const u64 *sieving_primes = __prime_generator_sieving_primes(prime_generator, int_sqrt(round_end), &sieving_prime_count);
+
+        // grow the bitmap now, it cant move while the workers are writing to it.
+        if (prime_generator->keep_bitmap && !__prime_generator_reserve_bitmap(prime_generator, round_end)) return false;
+
+        Prime_Generator_Round round = {
+            .prime_generator     = prime_generator,
+            .wheel               = wheel,
+            .sieving_primes      = sieving_primes,
+            .sieving_prime_count = sieving_prime_count,
+            .first_block_start   = block_start,
+            .block_count         = blocks_needed,
+            .task_count          = task_count,
+            .bitmap              = prime_generator->keep_bitmap ? prime_generator->bitmap.items : NULL,
+        };
+        pthread_mutex_init(&round.commit_lock, NULL);
+
+        // give everyone an even run of tasks to start with.
+        for (u64 i = 0; i < thread_count; i++) {
+            Prime_Generator_Worker *worker = &prime_generator->workers[i];
+            worker->round        = &round;
+            worker->worker_index = i;
+            worker->front        = task_count * i       / thread_count;
+            worker->back         = task_count * (i + 1) / thread_count;
+            pthread_mutex_init(&worker->queue_lock, NULL);
+        }
+
+        // the first worker runs on this thread, the rest get their own.
+        //
+        // if a thread fails to start, its tasks just get stolen.
+        for (u64 i = 1; i < thread_count; i++) {
+            Prime_Generator_Worker *worker = &prime_generator->workers[i];
+            worker->started = pthread_create(&worker->thread, NULL, __prime_generator_worker_main, worker) == 0;
+        }
+        __prime_generator_worker_main(&prime_generator->workers[0]);
+
+        for (u64 i = 1; i < thread_count; i++) {
+            Prime_Generator_Worker *worker = &prime_generator->workers[i];
+            if (worker->started) pthread_join(worker->thread, NULL);
+        }
+
+        for (u64 i = 0; i < thread_count; i++) pthread_mutex_destroy(&prime_generator->workers[i].queue_lock);
+        pthread_mutex_destroy(&round.commit_lock);
+
+        if (round.next_task_to_commit != task_count) {
+            PRIME_GENERATOR_ASSERT(round.next_task_to_commit == task_count && "some task never finished, this is a bug.");
+            return false;
+        }
+
+        prime_generator->last_prime_checked = round_end;
+        if (prime_generator->keep_bitmap) prime_generator->bitmap.count = __bitmap_word_count(wheel, round_end);
+        // our own sieve has to start over from here.
+        __reset_sieve(&prime_generator->sieve, round_end);
+        return true;
+    #endif // PRIME_GENERATOR_NO_THREADS
+}
+
+Prime_Generator_Internal void __free_workers(Prime_Generator *prime_generator) {
+    for (u64 i = 0; i < prime_generator->worker_count; i++) {
+        __free_sieve(&prime_generator->workers[i].sieve);
+    }
+    PRIME_GENERATOR_FREE(prime_generator->workers, prime_generator->worker_count * sizeof(Prime_Generator_Worker));
+
+    for (u64 i = 0; i < prime_generator->task_capacity; i++) {
+        Prime_Array_Free(&prime_generator->tasks[i].primes);
+    }
+    PRIME_GENERATOR_FREE(prime_generator->tasks, prime_generator->task_capacity * sizeof(Prime_Generator_Task));
+}
+
+
+// how many primes to reserve room for so that generating upto 'until' never has
+// to grow the array, we go a little past 'until', so add the most a block can hold.
+Prime_Generator_Internal void __prime_generator_reserve_until(Prime_Generator *prime_generator, u64 until) {
+    u64 prime_count = __prime_count_upper_bound(until) + PRIME_GENERATOR_BLOCK_BITS;
+
+    switch (prime_generator->storage) {
+        case PRIME_GENERATOR_STORAGE_COMPRESSED: {
+            Prime_Generator_Compressed_Primes *compressed = &prime_generator->compressed;
+            if (prime_count > compressed->count) __compressed_primes_reserve(compressed, prime_count - compressed->count);
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_U32: {
+            // the ones past 2^32 go in the normal array.
+            if (prime_count <= PRIME_GENERATOR_PRIMES_UNDER_2_32) {
+                Prime_Array_U32_Reserve(&prime_generator->u32_primes, prime_count);
+            } else {
+                Prime_Array_U32_Reserve(&prime_generator->u32_primes, PRIME_GENERATOR_PRIMES_UNDER_2_32);
+                Prime_Array_Reserve(&prime_generator->inner_prime_array, prime_count - PRIME_GENERATOR_PRIMES_UNDER_2_32);
+            }
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_MAPPED: {
+            // the file allready has the first ones.
+            u64 mapped_count = prime_generator->mapped.count;
+            if (prime_count > mapped_count) Prime_Array_Reserve(&prime_generator->inner_prime_array, prime_count - mapped_count);
+        } break;
+
+        case PRIME_GENERATOR_STORAGE_CHUNKED: {
+            // nothing, the chunks get made as they fill up, and nothing ever moves.
+        } break;
+
+        default: {
+            Prime_Array_Reserve(&prime_generator->inner_prime_array, prime_count);
+        } break;
+    }
+}
+
+
+
+
+
+// the first 'count' primes as an array, for the u64 storage this is just the generators array,
+// (and the file, for the mapped storage, if its u64's and has all of them) the others decode them into 'view'
+Prime_Generator_Internal Prime_Array __prime_generator_view(Prime_Generator *prime_generator, u64 count) {
+    if (prime_generator->storage == PRIME_GENERATOR_STORAGE_U64) return prime_generator->inner_prime_array;
+
+    if (prime_generator->storage == PRIME_GENERATOR_STORAGE_MAPPED && prime_generator->mapped.items && count <= prime_generator->mapped.count) {
+        return (Prime_Array){ .count = count, .items = (u64 *) prime_generator->mapped.items };
+    }
+
+    Prime_Array *view = &prime_generator->view;
+    view->count = 0;
+    if (!Prime_Array_Reserve(view, count)) return (Prime_Array){};
+
+    __prime_generator_decode(prime_generator, 0, count, view->items);
+    view->count = count;
+    return *view;
+}
+
+
+
+/////////////////////////////////////////////////
+//               PRIMALITY TEST
+/////////////////////////////////////////////////
+
+// numbers in Montgomery form, 'x * 2^64 mod n', for an odd 'n'
+// Wikipedia: https://en.wikipedia.org/wiki/Montgomery_modular_multiplication
+//
+// multiplying two of them is a couple of multiplies and a subtract, no dividing,
+// and Miller-Rabin is pretty much all multiplies.
+typedef struct Prime_Generator_Montgomery {
+    u64 n;
+    // n * n_inverse = 1 (mod 2^64)
+    u64 n_inverse;
+    // 2^64 mod n, (1 in Montgomery form)
+    u64 one;
+    // 2^128 mod n, (for getting numbers into Montgomery form)
+    u64 r_squared;
+} Prime_Generator_Montgomery;
+
+Prime_Generator_Internal Prime_Generator_Montgomery __montgomery_init(u64 n) {
+    Prime_Generator_Montgomery mont = { .n = n };
+
+    // Newton's method, every step doubles the correct bits, and n * n = 1 (mod 8) gives us 3 to start.
+    u64 inverse = n;
+    for (int i = 0; i < 5; i++) inverse *= 2 - n * inverse;
+    mont.n_inverse = inverse;
+
+    mont.one       = (0 - n) % n;
+    mont.r_squared = (u64)((unsigned __int128)mont.one * mont.one % n);
+    return mont;
+}
+
+// (a * b) / 2^64 mod n, so Montgomery times Montgomery stays in Montgomery form.
+Prime_Generator_Internal u64 __montgomery_mul(const Prime_Generator_Montgomery *mont, u64 a, u64 b) {
+    unsigned __int128 t = (unsigned __int128)a * b;
+    u64 t_low  = (u64) t;
+    u64 t_high = (u64)(t >> 64);
+
+    // m * n has the same low 64 bits as t, so t - m * n is a multiple of 2^64.
+    u64 m = t_low * mont->n_inverse;
+    u64 mn_high = (u64)(((unsigned __int128)m * mont->n) >> 64);
+
+    u64 result = t_high - mn_high;
+    if (t_high < mn_high) result += mont->n;
+    return result;
+}
+
+Prime_Generator_Internal u64 __montgomery_pow(const Prime_Generator_Montgomery *mont, u64 base, u64 exponent) {
+    u64 result = mont->one;
+    while (exponent) {
+        if (exponent & 1) result = __montgomery_mul(mont, result, base);
+        base = __montgomery_mul(mont, base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// Miller-Rabin, for numbers the generator has not got to yet.
+// Wikipedia: https://en.wikipedia.org/wiki/Miller%E2%80%93Rabin_primality_test
+//
+// its normally a probable prime test, but these 7 bases (found by Jim Sinclair)
+// have been checked against every number under 2^64, so this is never wrong.
+Prime_Generator_Internal bool __miller_rabin(u64 n) {
+    static const u64 small_primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    static const u64 bases[]        = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+
+    if (n < 2) return false;
+    // gets the small ones, and most of the composites, way faster than a round of Miller-Rabin.
+    for (u64 i = 0; i < sizeof(small_primes) / sizeof(small_primes[0]); i++) {
+        if (n % small_primes[i] == 0) return n == small_primes[i];
+    }
+    if (n < 37 * 37) return true;
+
+    // n - 1 = d * 2^s, with d odd.
+    u64 d = n - 1;
+    u64 s = PRIME_GENERATOR_CTZ(d);
+    d >>= s;
+
+    Prime_Generator_Montgomery mont = __montgomery_init(n);
+    u64 minus_one = n - mont.one;
+
+    for (u64 i = 0; i < sizeof(bases) / sizeof(bases[0]); i++) {
+        u64 base = bases[i] % n;
+        // a base thats a multiple of n says nothing.
+        if (base == 0) continue;
+
+        u64 x = __montgomery_pow(&mont, __montgomery_mul(&mont, base, mont.r_squared), d);
+        if (x == mont.one || x == minus_one) continue;
+
+        // square untill we hit n - 1, if we never do, 'n' is not a prime.
+        u64 r = 1;
+        for (; r < s; r++) {
+            x = __montgomery_mul(&mont, x, x);
+            if (x == minus_one) break;
+        }
+        if (r == s) return false;
+    }
+    return true;
+}
+
+
+
+/////////////////////////////////////////////////
+//               PRIME COUNTING
+/////////////////////////////////////////////////
+
+// below this, 'count_primes_under_n()' just generates the primes and counts them.
+#ifndef PRIME_GENERATOR_COUNT_BY_SIEVING_UNDER
+    #define PRIME_GENERATOR_COUNT_BY_SIEVING_UNDER    (1ULL << 24)
+#endif // PRIME_GENERATOR_COUNT_BY_SIEVING_UNDER
+
+// how many of the primes the generator has are under 'n', (binary search)
+Prime_Generator_Internal u64 __prime_generator_count_under(const Prime_Generator *prime_generator, u64 n) {
+    u64 low  = 0;
+    u64 high = __prime_generator_count(prime_generator);
+    while (low < high) {
+        u64 mid = (low + high) / 2;
+        if (__prime_generator_get(prime_generator, mid) < n) low  = mid + 1;
+        else                                                 high = mid;
+    }
+    return low;
+}
+
+
+// 2 * 3 * 5 * 7 * 11 * 13, phi(x, 6) repeats every this many numbers.
+#define PRIME_GENERATOR_PHI_PRIMORIAL        30030
+// how many numbers in one primorial are coprime to it.
+#define PRIME_GENERATOR_PHI_PRIMORIAL_TOTIENT 5760
+#define PRIME_GENERATOR_PHI_SMALL_PRIMES      6
+
+// the size of the phi cache, (2 bytes each) x has to fit in a uint16_t.
+#define PRIME_GENERATOR_PHI_CACHE_X          (1 << 16)
+#define PRIME_GENERATOR_PHI_CACHE_A          64
+
+// everything the Meissel-Lehmer method needs.
+typedef struct Prime_Generator_Counter {
+    // every prime upto 'limit', (at least)
+    const u64 *primes;
+    u64 prime_count;
+
+    // pi(v) for any v <= limit, 1 bit per odd number, and how many primes came before each word.
+    u64 limit;
+    u64 *odd_prime_bits;
+    uint32_t *odd_prime_counts;
+    u64 word_count;
+
+    // phi_small[r] = phi(r, 6), for r < PRIME_GENERATOR_PHI_PRIMORIAL
+    uint16_t *phi_small;
+
+    // phi(x, a) for small x and a, the same ones come up over and over,
+    // 'phi_cache[a * PRIME_GENERATOR_PHI_CACHE_X + x]', 0 means we havent done it yet.
+    uint16_t *phi_cache;
+} Prime_Generator_Counter;
+
+// pi(v), v has to be <= counter->limit
+Prime_Generator_Internal u64 __counter_pi(const Prime_Generator_Counter *counter, u64 v) {
+    if (v < 2) return 0;
+
+    u64 bit  = (v - 1) / 2;
+    u64 mask = (2ULL << (bit % 64)) - 1; // every bit upto and including 'bit', (wraps to all of them for bit 63)
+    // +1 for 2, the only even one.
+    return 1 + counter->odd_prime_counts[bit / 64] + PRIME_GENERATOR_POPCOUNT(counter->odd_prime_bits[bit / 64] & mask);
+}
+
+// phi(x, a) is how many numbers in [1, x] are not divisible by any of the first 'a' primes.
+//
+// uses phi(x, a) = phi(x, a-1) - phi(x / p_a, a-1), but unrolled all the way down to
+// phi(x, 6), witch is just a table lookup, and stops early when the answer is simple:
+//     - if x < p_(a+1), only 1 is left.
+//     - if x < p_(a+1)^2, whats left is 1 and the primes bigger than p_a, (witch we can look up)
+Prime_Generator_Internal u64 __counter_phi(Prime_Generator_Counter *counter, u64 x, u64 a) {
+    const u64 *primes = counter->primes;
+
+    u64 phi_small = (x / PRIME_GENERATOR_PHI_PRIMORIAL) * PRIME_GENERATOR_PHI_PRIMORIAL_TOTIENT + counter->phi_small[x % PRIME_GENERATOR_PHI_PRIMORIAL];
+    if (a <= PRIME_GENERATOR_PHI_SMALL_PRIMES) return phi_small;
+
+    // (primes is 0 indexed, so primes[a] is p_(a+1))
+    if (x < primes[a]) return x ? 1 : 0;
+    if (x <= counter->limit && x < primes[a] * primes[a]) return __counter_pi(counter, x) - a + 1;
+
+    bool cacheable = (x < PRIME_GENERATOR_PHI_CACHE_X && a < PRIME_GENERATOR_PHI_CACHE_A);
+    if (cacheable && counter->phi_cache[a * PRIME_GENERATOR_PHI_CACHE_X + x]) return counter->phi_cache[a * PRIME_GENERATOR_PHI_CACHE_X + x];
+
+    u64 result = phi_small;
+    for (u64 i = PRIME_GENERATOR_PHI_SMALL_PRIMES; i < a; i++) {
+        u64 y = x / primes[i];
+        // all the ones after this only have 1 left.
+        if (y < primes[i]) {
+            result -= a - i;
+            break;
+        }
+        // same as the checks at the top, but skips the call, most of them end up here.
+        if (y <= counter->limit && y < primes[i] * primes[i]) {
+            result -= __counter_pi(counter, y) - i + 1;
+            continue;
+        }
+        result -= __counter_phi(counter, y, i);
+    }
+
+    if (cacheable) counter->phi_cache[a * PRIME_GENERATOR_PHI_CACHE_X + x] = (uint16_t) result;
+    return result;
+}
+
+Prime_Generator_Internal void __free_counter(Prime_Generator_Counter *counter) {
+    PRIME_GENERATOR_FREE(counter->odd_prime_bits,   counter->word_count * sizeof(u64));
+    PRIME_GENERATOR_FREE(counter->odd_prime_counts, counter->word_count * sizeof(uint32_t));
+    PRIME_GENERATOR_FREE(counter->phi_small,        PRIME_GENERATOR_PHI_PRIMORIAL * sizeof(uint16_t));
+    PRIME_GENERATOR_FREE(counter->phi_cache,        PRIME_GENERATOR_PHI_CACHE_A * PRIME_GENERATOR_PHI_CACHE_X * sizeof(uint16_t));
+}
+
+// how many bits of a block are for numbers <= 'v', ('v' is in the block)
+Prime_Generator_Internal u64 __bits_upto(const Prime_Generator_Wheel *wheel, u64 block_start, u64 v) {
+    u64 offset = v - block_start;
+    u64 bits   = (offset / wheel->modulus) * wheel->residue_count;
+
+    u64 remainder = offset % wheel->modulus;
+    for (u64 i = 0; i < wheel->residue_count && wheel->residues[i] <= remainder; i++) bits += 1;
+    return bits;
+}
+
+// pi(x) with Meissel's formula, the generator has to have every prime upto max(sqrt(x), the first block)
+// Wikipedia: https://en.wikipedia.org/wiki/Meissel%E2%80%93Lehmer_algorithm
+//
+//     pi(x) = phi(x, a) + a - 1 - P2(x, a),  where a = pi(cbrt(x))
+//
+// P2 is how many numbers upto x are the product of 2 primes bigger than p_a,
+// that needs pi(x / p) for every prime p between cbrt(x) and sqrt(x), witch can be as big
+// as x^(2/3), so we run the generators sieve over them, counting the primes instead of keeping them.
+Prime_Generator_Internal u64 __meissel_pi(Prime_Generator *prime_generator, u64 x, u64 limit) {
+    const Prime_Generator_Wheel *wheel = prime_generator->wheel;
+    const Prime_Generator_Kernels *kernels = &prime_generator_kernels[wheel->isa];
+
+    Prime_Generator_Counter counter = { .limit = limit };
+    counter.primes = __prime_generator_sieving_primes(prime_generator, limit, &counter.prime_count);
+
+    // the pi table.
+    counter.word_count       = (limit - 1) / 2 / 64 + 1;
+    counter.odd_prime_bits   = PRIME_GENERATOR_REALLOC(NULL, 0, counter.word_count * sizeof(u64));
+    counter.odd_prime_counts = PRIME_GENERATOR_REALLOC(NULL, 0, counter.word_count * sizeof(uint32_t));
+    counter.phi_small        = PRIME_GENERATOR_REALLOC(NULL, 0, PRIME_GENERATOR_PHI_PRIMORIAL * sizeof(uint16_t));
+    counter.phi_cache        = PRIME_GENERATOR_REALLOC(NULL, 0, PRIME_GENERATOR_PHI_CACHE_A * PRIME_GENERATOR_PHI_CACHE_X * sizeof(uint16_t));
+    if (!counter.odd_prime_bits || !counter.odd_prime_counts || !counter.phi_small || !counter.phi_cache) {
+        PRIME_GENERATOR_ASSERT(false && "You ran out of memory, how?");
+        __free_counter(&counter);
+        return 0;
+    }
+    PRIME_GENERATOR_MEM_ZERO(counter.phi_cache, PRIME_GENERATOR_PHI_CACHE_A * PRIME_GENERATOR_PHI_CACHE_X * sizeof(uint16_t));
+
+    PRIME_GENERATOR_MEM_ZERO(counter.odd_prime_bits, counter.word_count * sizeof(u64));
+    for (u64 i = 1; i < counter.prime_count && counter.primes[i] <= limit; i++) {
+        u64 bit = (counter.primes[i] - 1) / 2;
+        counter.odd_prime_bits[bit / 64] |= 1ULL << (bit % 64);
+    }
+    u64 running_count = 0;
+    for (u64 i = 0; i < counter.word_count; i++) {
+        counter.odd_prime_counts[i] = (uint32_t) running_count;
+        running_count += PRIME_GENERATOR_POPCOUNT(counter.odd_prime_bits[i]);
+    }
+
+    // phi(r, 6) for one whole primorial.
+    counter.phi_small[0] = 0;
+    for (u64 r = 1; r < PRIME_GENERATOR_PHI_PRIMORIAL; r++) {
+        bool coprime = (r % 2) && (r % 3) && (r % 5) && (r % 7) && (r % 11) && (r % 13);
+        counter.phi_small[r] = counter.phi_small[r-1] + coprime;
+    }
+
+
+    u64 a = __counter_pi(&counter, int_cbrt(x));
+    u64 b = __counter_pi(&counter, int_sqrt(x));
+
+    u64 result = __counter_phi(&counter, x, a) + a - 1;
+
+
+    // P2(x, a) = sum over a < i <= b, of pi(x / p_i) - (i - 1)
+    //
+    // going from p_b down, x / p_i only goes up, so we can count the primes one block after another.
+    u64 i = b;
+    for (; i > a && x / counter.primes[i-1] <= limit; i--) {
+        result -= __counter_pi(&counter, x / counter.primes[i-1]) - (i - 1);
+    }
+
+    if (i > a) {
+        // start on a whole word of turns, with everything before it in the table.
+        u64 numbers_per_64_turns = wheel->modulus * 64;
+        u64 block_start = (limit + 1) / numbers_per_64_turns * numbers_per_64_turns;
+        u64 primes_before_block = __counter_pi(&counter, block_start - 1);
+
+        Prime_Generator_Sieve sieve = {};
+        __reset_sieve(&sieve, block_start);
+
+        u64 is_not_prime_bits[PRIME_GENERATOR_BLOCK_WORDS];
+
+        for (; i > a; block_start += wheel->numbers_per_block) {
+            u64 block_end = block_start + wheel->numbers_per_block;
+
+            __sieve_add_primes(&sieve, wheel, counter.primes, counter.prime_count, block_end);
+            __sieve_block(&sieve, wheel, is_not_prime_bits);
+
+            // the targets only go up, so only count the words we havent counted yet.
+            u64 words_counted = 0;
+            for (; i > a && x / counter.primes[i-1] < block_end; i--) {
+                u64 bits = __bits_upto(wheel, block_start, x / counter.primes[i-1]);
+
+                primes_before_block += kernels->count(is_not_prime_bits + words_counted, bits / 64 - words_counted);
+                words_counted = bits / 64;
+
+                u64 pi = primes_before_block;
+                if (bits % 64) {
+                    u64 mask = (1ULL << (bits % 64)) - 1;
+                    pi += (bits % 64) - PRIME_GENERATOR_POPCOUNT(is_not_prime_bits[words_counted] & mask);
+                }
+                result -= pi - (i - 1);
+            }
+
+            primes_before_block += kernels->count(is_not_prime_bits + words_counted, wheel->bits_per_block / 64 - words_counted);
+        }
+
+        __free_sieve(&sieve);
+    }
+
+    __free_counter(&counter);
+    return result;
+}
+
+
+
+void clear_prime_generator(Prime_Generator *prime_generator) {
+    // this will always exist, and we will always preseve it.
+    void *allocator = prime_generator->allocator;
+    // the layout, isa, storage, bitmap and thread count are settings, so keep them as well.
+    Prime_Generator_Layout  layout  = prime_generator->layout;
+    Prime_Generator_Isa     isa     = prime_generator->isa;
+    Prime_Generator_Storage storage = prime_generator->storage;
+    bool keep_bitmap = prime_generator->keep_bitmap;
+    // the file is about to be unmapped, so its a normal generator again.
+    if (storage == PRIME_GENERATOR_STORAGE_MAPPED) storage = PRIME_GENERATOR_STORAGE_U64;
+    u64 thread_count = prime_generator->thread_count;
+
+    __free_prime_generator_wheel(prime_generator->wheel);
+    __free_sieve(&prime_generator->sieve);
+    __free_workers(prime_generator);
+
+    __free_compressed_primes(&prime_generator->compressed);
+    Prime_Array_U32_Free(&prime_generator->u32_primes);
+    __free_mapped_primes(&prime_generator->mapped);
+    __free_chunked_primes(&prime_generator->chunked);
+    Prime_Array_Free(&prime_generator->staging);
+    Prime_Array_Free(&prime_generator->sieving_prime_table);
+    Prime_Array_Free(&prime_generator->view);
+    Prime_Array_Free(&prime_generator->bitmap);
+
     #if USING_BESTED_H
         // free malloc'd array if not allocator
         if (!allocator) Array_Free(&prime_generator->inner_prime_array);
@@ -451,88 +3386,842 @@ void clear_prime_generator(Prime_Generator *prime_generator) {
 
     // we zero initialize the prime_generator for a second time.
     PRIME_GENERATOR_MEM_ZERO(prime_generator, sizeof(*prime_generator));
-    prime_generator->allocator = allocator;
+    prime_generator->allocator    = allocator;
+    prime_generator->layout       = layout;
+    prime_generator->isa          = isa;
+    prime_generator->storage      = storage;
+    prime_generator->keep_bitmap  = keep_bitmap;
+    prime_generator->thread_count = thread_count;
+}
+
+
+// 1 indexed
+u64 get_nth_prime(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator || n == 0) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
+        return 2; // this is obviously incorrect, but might be better then returning 0?
+    }
+    generate_primes_until_nth_prime(prime_generator, n);
+    return __prime_generator_get(prime_generator, n-1);
+}
+
+
+void generate_primes_under_n(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        return;
+    }
+    // grow the array once, not every couple of blocks.
+    if (prime_generator->last_prime_checked < n) __prime_generator_reserve_until(prime_generator, n);
+
+    while (prime_generator->last_prime_checked < n) {
+        if (__generate_prime_blocks_in_parallel(prime_generator, n)) continue;
+        __generate_prime_block(prime_generator);
+    }
+}
+
+void generate_primes_until_nth_prime(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator || n == 0) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
+        return;
+    }
+
+    u64 index = n - 1;
+
+    u64 until = __nth_prime_upper_bound(n);
+
+    // reserve amount needed so we dont have to reallocate.
+    if (__prime_generator_count(prime_generator) <= index) __prime_generator_reserve_until(prime_generator, until);
+
+    while (__prime_generator_count(prime_generator) <= index) {
+        if (__generate_prime_blocks_in_parallel(prime_generator, until)) continue;
+        __generate_prime_block(prime_generator);
+    }
+}
+
+Prime_Array get_all_primes_upto_nth_prime(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator || n == 0) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
+        return (Prime_Array){};
+    }
+
+    generate_primes_until_nth_prime(prime_generator, n);
+
+    Prime_Array result = __prime_generator_view(prime_generator, n);
+    result.count = n;
+    return result;
+}
+
+Prime_Array get_all_primes_under_n(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        return (Prime_Array){};
+    }
+
+    generate_primes_under_n(prime_generator, n);
+
+    // binary search the storage first, so the storages that decode
+    // only decode the ones under n, not every prime we have.
+    u64 count = __prime_generator_count_under(prime_generator, n);
+
+    Prime_Array result = __prime_generator_view(prime_generator, count);
+    result.count = count;
+    return result;
+}
+
+
+bool is_prime(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        return false;
+    }
+    if (n < 2) return false;
+
+    const Prime_Generator_Wheel *wheel = prime_generator->wheel;
+
+    // bigger than anything we have checked, (or we havent started) so do it the hard way.
+    if (!wheel || n >= prime_generator->last_prime_checked) return __miller_rabin(n);
+
+    // these share a factor with the modulus, so they dont have a bit,
+    // the only primes in here are the ones that make up the wheel.
+    if (wheel->residue_index[n % wheel->modulus] == PRIME_GENERATOR_NOT_ON_WHEEL) {
+        return n == 2 || n == 3 || n == 5 || n == 7;
+    }
+
+    if (prime_generator->keep_bitmap) {
+        u64 bit = (n / wheel->modulus) * wheel->residue_count + wheel->residue_index[n % wheel->modulus];
+        if (bit / 64 < prime_generator->bitmap.count) {
+            return (prime_generator->bitmap.items[bit / 64] >> (bit % 64)) & 1;
+        }
+    }
+
+    // no bitmap, look for it in the primes we have.
+    u64 index = __prime_generator_count_under(prime_generator, n);
+    return index < __prime_generator_count(prime_generator) && __prime_generator_get(prime_generator, index) == n;
+}
+
+bool is_prime_no_generator(u64 n) {
+    return __miller_rabin(n);
 }
 
+// the biggest prime that fits in a u64.
+#define PRIME_GENERATOR_LARGEST_U64_PRIME    18446744073709551557ULL
 
-// 1 indexed
-u64 get_nth_prime(Prime_Generator *prime_generator, u64 n) {
-    if (!prime_generator || n == 0) {
+u64 next_prime(Prime_Generator *prime_generator, u64 x) {
+    if (!prime_generator) {
         PRIME_GENERATOR_ASSERT(prime_generator);
-        PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
-        return 2; // this is obviously incorrect, but might be better then returning 0?
+        return 0;
     }
-    generate_primes_until_nth_prime(prime_generator, n);
-    return prime_generator->inner_prime_array.items[n-1];
+    // there are no more primes that fit in a u64, the header says this is 0, so its not an error.
+    if (x > PRIME_GENERATOR_LARGEST_U64_PRIME) return 0;
+    if (x <= 2) return 2;
+
+    // the generator has one thats at least x.
+    u64 index = __prime_generator_count_under(prime_generator, x);
+    if (index < __prime_generator_count(prime_generator)) return __prime_generator_get(prime_generator, index);
+
+    // 2 is taken care of, so only try the odd ones.
+    u64 n = x | 1;
+    while (!__miller_rabin(n)) n += 2;
+    return n;
 }
 
+u64 prev_prime(Prime_Generator *prime_generator, u64 x) {
+    if (!prime_generator) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        return 0;
+    }
+    // there are no primes under 2, same as above.
+    if (x < 2) return 0;
+    if (x < 3) return 2;
 
-void generate_primes_under_n(Prime_Generator *prime_generator, u64 n) {
+    // the generator has checked everything upto x, so the one before it is the answer.
+    if (x < prime_generator->last_prime_checked) {
+        u64 index = __prime_generator_count_under(prime_generator, x + 1);
+        return __prime_generator_get(prime_generator, index - 1);
+    }
+
+    u64 n = (x % 2) ? x : x - 1;
+    while (!__miller_rabin(n)) n -= 2;
+    return n;
+}
+
+u64 count_primes_under_n(Prime_Generator *prime_generator, u64 n) {
     if (!prime_generator) {
         PRIME_GENERATOR_ASSERT(prime_generator);
-        return;
+        return 0;
+    }
+    if (n < 3) return 0;
+
+    // we allready have them, or its not worth doing anything fancy.
+    if (n <= prime_generator->last_prime_checked || n < PRIME_GENERATOR_COUNT_BY_SIEVING_UNDER) {
+        generate_primes_under_n(prime_generator, n);
+        return __prime_generator_count_under(prime_generator, n);
     }
-    while (prime_generator->last_prime_checked < n)       { __generate_prime_block(prime_generator); }
+
+    // counting primes <= x.
+    u64 x = n - 1;
+
+    // start the generator, so theres a wheel, and the counting sieve can start after the first block.
+    generate_primes_under_n(prime_generator, 1);
+    if (!prime_generator->wheel) return 0;
+
+    // a bigger table makes it a little faster, but not by enough to make it huge.
+    u64 limit = int_sqrt(x);
+    if (limit < prime_generator->wheel->first_block_end - 1) limit = prime_generator->wheel->first_block_end - 1;
+    return __meissel_pi(prime_generator, x, limit);
 }
 
-void generate_primes_until_nth_prime(Prime_Generator *prime_generator, u64 n) {
+u64 find_nth_prime(Prime_Generator *prime_generator, u64 n) {
     if (!prime_generator || n == 0) {
         PRIME_GENERATOR_ASSERT(prime_generator);
         PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
+        return 2;
+    }
+
+    // we allready have it.
+    if (n <= __prime_generator_count(prime_generator)) return __prime_generator_get(prime_generator, n-1);
+
+    u64 estimate = __nth_prime_estimate(n);
+    if (estimate < PRIME_GENERATOR_COUNT_BY_SIEVING_UNDER) return get_nth_prime(prime_generator, n);
+
+    // pi(x) and li(x) are about sqrt(x) * ln(x) / (8 * pi) apart, (if the Riemann hypothesis is true)
+    // and the primes are about ln(x) apart, so start a bit before that.
+    double ln_estimate = __prime_generator_ln((double) estimate);
+    u64 margin = (u64)((double) int_sqrt(estimate) * ln_estimate * ln_estimate / 25);
+
+    // start the generator, so theres a wheel, and the window sieve can start after the first block.
+    generate_primes_under_n(prime_generator, 1);
+    const Prime_Generator_Wheel *wheel = prime_generator->wheel;
+    if (!wheel) return 0;
+    const Prime_Generator_Kernels *kernels = &prime_generator_kernels[wheel->isa];
+
+    // count everything before the window, if we went past it, back up some more.
+    u64 numbers_per_64_turns = wheel->modulus * 64;
+    u64 block_start, count;
+    while (true) {
+        block_start = (estimate > margin) ? estimate - margin : 0;
+        block_start = block_start / numbers_per_64_turns * numbers_per_64_turns;
+        if (block_start < wheel->first_block_end) return get_nth_prime(prime_generator, n);
+
+        count = count_primes_under_n(prime_generator, block_start);
+        if (count < n) break;
+        margin *= 2;
+    }
+
+    // sieve forward, counting, untill the block with the nth prime in it.
+    Prime_Generator_Sieve sieve = {};
+    __reset_sieve(&sieve, block_start);
+
+    u64 is_not_prime_bits[PRIME_GENERATOR_BLOCK_WORDS];
+    u64 result = 0;
+    while (true) {
+        u64 block_end = block_start + wheel->numbers_per_block;
+
+        // we only ever need the primes upto sqrt of where we are.
+        u64 sieving_prime_count;
+        const u64 *sieving_primes = __prime_generator_sieving_primes(prime_generator, int_sqrt(block_end), &sieving_prime_count);
+
+        __sieve_add_primes(&sieve, wheel, sieving_primes, sieving_prime_count, block_end);
+        __sieve_block(&sieve, wheel, is_not_prime_bits);
+
+        u64 block_count = kernels->count(is_not_prime_bits, wheel->bits_per_block / 64);
+        if (count + block_count >= n) {
+            Prime_Array window = {};
+            __extract_primes(wheel, &window, is_not_prime_bits, block_start);
+            if (n - count - 1 < window.count) result = window.items[n - count - 1];
+            Prime_Array_Free(&window);
+            break;
+        }
+
+        count       += block_count;
+        block_start  = block_end;
+    }
+
+    __free_sieve(&sieve);
+    return result;
+}
+
+void for_each_prime_in_range(Prime_Generator *prime_generator, u64 lo, u64 hi, Prime_Generator_Callback callback, void *user_data) {
+    if (!prime_generator || !callback) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(callback && "must pass in a callback, got NULL");
+        return;
+    }
+    if (hi > (1ULL << 60)) {
+        PRIME_GENERATOR_ASSERT(hi <= (1ULL << 60) && "This is getting a little out of hand.");
         return;
     }
+    if (lo >= hi) return;
 
-    #if USING_BESTED_H
-        // reserve amount needed so we dont have to reallocate.
-        Array_Reserve(&prime_generator->inner_prime_array, n);
+    // start the generator, so theres a wheel, and the sieve can start after the first block.
+    generate_primes_under_n(prime_generator, 1);
+    const Prime_Generator_Wheel *wheel = prime_generator->wheel;
+    if (!wheel) return;
+
+    // the block buffer, reused for every block.
+    Prime_Array buffer = {};
+
+    // the part we allready have, u64 storage hands them out as is, the others decode a chunk at a time.
+    u64 have_upto = prime_generator->last_prime_checked;
+    if (lo < have_upto) {
+        u64 first = __prime_generator_count_under(prime_generator, lo);
+        u64 last  = __prime_generator_count_under(prime_generator, hi < have_upto ? hi : have_upto);
+
+        if (prime_generator->storage == PRIME_GENERATOR_STORAGE_U64) {
+            if (last > first && !callback(&prime_generator->inner_prime_array.items[first], last - first, user_data)) return;
+        } else {
+            if (!Prime_Array_Reserve(&buffer, PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE)) return;
+            for (u64 i = first; i < last; i += PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE) {
+                u64 count = (last - i < PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE) ? last - i : PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE;
+                __prime_generator_decode(prime_generator, i, count, buffer.items);
+                if (!callback(buffer.items, count, user_data)) {
+                    Prime_Array_Free(&buffer);
+                    return;
+                }
+            }
+        }
+
+        if (hi <= have_upto) {
+            Prime_Array_Free(&buffer);
+            return;
+        }
+    }
+
+    // sieve the rest, from the start of the word of turns that has 'lo' in it.
+    u64 numbers_per_64_turns = wheel->modulus * 64;
+    u64 block_start = lo / numbers_per_64_turns * numbers_per_64_turns;
+    if (block_start < have_upto) block_start = have_upto;
+
+    u64 sieving_prime_count;
+    const u64 *sieving_primes = __prime_generator_sieving_primes(prime_generator, int_sqrt(hi - 1), &sieving_prime_count);
+
+    Prime_Generator_Sieve sieve = {};
+    __reset_sieve(&sieve, block_start);
+
+    u64 is_not_prime_bits[PRIME_GENERATOR_BLOCK_WORDS];
+    for (; block_start < hi; block_start += wheel->numbers_per_block) {
+        __sieve_add_primes(&sieve, wheel, sieving_primes, sieving_prime_count, block_start + wheel->numbers_per_block);
+        __sieve_block(&sieve, wheel, is_not_prime_bits);
+
+        buffer.count = 0;
+        __extract_primes(wheel, &buffer, is_not_prime_bits, block_start);
+
+        // the first and last blocks stick out past the range, cut them down.
+        u64 first = 0;
+        while (first < buffer.count && buffer.items[first] < lo) first += 1;
+        while (buffer.count > first && buffer.items[buffer.count-1] >= hi) buffer.count -= 1;
+
+        if (buffer.count > first && !callback(&buffer.items[first], buffer.count - first, user_data)) break;
+    }
+
+    __free_sieve(&sieve);
+    Prime_Array_Free(&buffer);
+}
+
+// 'get_primes_in_range()' is just the callback above, adding them to the array.
+Prime_Generator_Internal bool __append_primes_callback(const u64 *primes, u64 count, void *user_data) {
+    Prime_Array_Append_Many((Prime_Array *) user_data, primes, count);
+    return true;
+}
+
+void get_primes_in_range(Prime_Generator *prime_generator, u64 lo, u64 hi, Prime_Array *result) {
+    if (!result) {
+        PRIME_GENERATOR_ASSERT(result && "must pass in a valid result array, got NULL");
+        return;
+    }
+    for_each_prime_in_range(prime_generator, lo, hi, __append_primes_callback, result);
+}
+
+
+#ifndef PRIME_GENERATOR_NO_FILES
+
+// cache files are written next to 'path', as 'path' + ".tmp", and renamed over it once they are done.
+Prime_Generator_Internal FILE *__open_cache_temp_file(const char *path, char **temp_path) {
+    u64 path_length = strlen(path);
+    *temp_path = PRIME_GENERATOR_REALLOC(NULL, 0, path_length + 5);
+    if (!*temp_path) {
+        PRIME_GENERATOR_ASSERT(*temp_path && "You ran out of memory, how?");
+        return NULL;
+    }
+    PRIME_GENERATOR_MEM_COPY(*temp_path, path, path_length);
+    PRIME_GENERATOR_MEM_COPY(*temp_path + path_length, ".tmp", 5);
+
+    FILE *file = fopen(*temp_path, "wb");
+    if (!file) PRIME_GENERATOR_FREE(*temp_path, path_length + 5);
+    return file;
+}
+
+// close the temp file, and put it where it goes if everything got written.
+Prime_Generator_Internal bool __finish_cache_temp_file(FILE *file, char *temp_path, const char *path, bool wrote_everything) {
+    // fclose can fail too, the last of it gets written then.
+    wrote_everything = (fclose(file) == 0) && wrote_everything;
+    wrote_everything = wrote_everything && rename(temp_path, path) == 0;
+
+    if (!wrote_everything) remove(temp_path);
+    PRIME_GENERATOR_FREE(temp_path, strlen(temp_path) + 1);
+    return wrote_everything;
+}
+
+#endif // PRIME_GENERATOR_NO_FILES
+
+bool save_prime_generator(Prime_Generator *prime_generator, const char *path) {
+    if (!prime_generator || !path) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(path && "must pass in a path, got NULL");
+        return false;
+    }
+
+    #ifdef PRIME_GENERATOR_NO_FILES
+        return false;
     #else
-        // we could do something here, but I'm lazy.
-    #endif // USING_BESTED_H
+        char *temp_path;
+        FILE *file = __open_cache_temp_file(path, &temp_path);
+        if (!file) return false;
 
-    u64 index = n - 1;
+        u64 count = __prime_generator_count(prime_generator);
 
-    while (prime_generator->inner_prime_array.count <= index) { __generate_prime_block(prime_generator); }
+        Prime_Generator_Cache_Header header = {
+            .version            = PRIME_GENERATOR_CACHE_VERSION,
+            .count              = count,
+            .last_prime_checked = prime_generator->last_prime_checked,
+        };
+        PRIME_GENERATOR_MEM_COPY(header.magic, PRIME_GENERATOR_CACHE_MAGIC, sizeof(header.magic));
+
+        bool wrote_everything = fwrite(&header, sizeof(header), 1, file) == 1;
+
+        if (prime_generator->storage == PRIME_GENERATOR_STORAGE_U64) {
+            wrote_everything = wrote_everything && fwrite(prime_generator->inner_prime_array.items, sizeof(u64), count, file) == count;
+        } else {
+            u64 chunk[PRIME_GENERATOR_CACHE_DECODE_SIZE];
+            for (u64 i = 0; wrote_everything && i < count; i += PRIME_GENERATOR_CACHE_DECODE_SIZE) {
+                u64 chunk_count = (count - i < PRIME_GENERATOR_CACHE_DECODE_SIZE) ? count - i : PRIME_GENERATOR_CACHE_DECODE_SIZE;
+                __prime_generator_decode(prime_generator, i, chunk_count, chunk);
+                wrote_everything = fwrite(chunk, sizeof(u64), chunk_count, file) == chunk_count;
+            }
+        }
+
+        return __finish_cache_temp_file(file, temp_path, path, wrote_everything);
+    #endif // PRIME_GENERATOR_NO_FILES
 }
 
-Prime_Array get_all_primes_upto_nth_prime(Prime_Generator *prime_generator, u64 n) {
-    if (!prime_generator || n == 0) {
+bool load_prime_generator(Prime_Generator *prime_generator, const char *path) {
+    if (!prime_generator || !path) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(path && "must pass in a path, got NULL");
+        return false;
+    }
+    if (prime_generator->wheel || __prime_generator_count(prime_generator) != 0) {
+        PRIME_GENERATOR_ASSERT(!prime_generator->wheel && "can only load into a fresh generator, clear it first");
+        return false;
+    }
+    if (prime_generator->storage != PRIME_GENERATOR_STORAGE_U64 && prime_generator->storage != PRIME_GENERATOR_STORAGE_MAPPED) {
+        PRIME_GENERATOR_ASSERT(false && "the file is used as is, and the primes after it are u64's, so it only loads into a generator with PRIME_GENERATOR_STORAGE_U64");
+        return false;
+    }
+
+    Prime_Generator_Mapped_Primes mapped = {};
+    u64 file_last_prime_checked = 0;
+    if (!__map_prime_cache(path, &mapped, &file_last_prime_checked)) return false;
+
+    prime_generator->storage = PRIME_GENERATOR_STORAGE_MAPPED;
+    prime_generator->mapped  = mapped;
+    if (!__prime_generator_wheel_init(prime_generator)) {
+        clear_prime_generator(prime_generator);
+        return false;
+    }
+    const Prime_Generator_Wheel *wheel = prime_generator->wheel;
+
+    // the blocks after the first one have to start on a whole word, (and the file might be
+    // from a different layout) so only use the file upto the last word it covers.
+    u64 numbers_per_word = wheel->modulus * 64;
+    u64 start = (file_last_prime_checked / numbers_per_word) * numbers_per_word;
+
+    // not even the first block, its faster to just make it.
+    if (start < wheel->first_block_end) {
+        clear_prime_generator(prime_generator);
+        return false;
+    }
+
+    // binary search for the primes under 'start'
+    u64 low  = 0;
+    u64 high = mapped.count;
+    while (low < high) {
+        u64 mid = (low + high) / 2;
+        u64 prime;
+        __mapped_primes_decode(&mapped, mid, 1, &prime);
+
+        if (prime < start) low  = mid + 1;
+        else               high = mid;
+    }
+    prime_generator->mapped.count = low;
+
+    // the bits arent in the file, but the primes are, so just set them.
+    if (prime_generator->keep_bitmap) {
+        Prime_Array *bitmap = &prime_generator->bitmap;
+        if (!__prime_generator_reserve_bitmap(prime_generator, start)) {
+            clear_prime_generator(prime_generator);
+            return false;
+        }
+
+        bitmap->count = __bitmap_word_count(wheel, start);
+        PRIME_GENERATOR_MEM_ZERO(bitmap->items, bitmap->count * sizeof(u64));
+
+        u64 chunk[PRIME_GENERATOR_CACHE_DECODE_SIZE];
+        for (u64 i = 0; i < low; i += PRIME_GENERATOR_CACHE_DECODE_SIZE) {
+            u64 chunk_count = (low - i < PRIME_GENERATOR_CACHE_DECODE_SIZE) ? low - i : PRIME_GENERATOR_CACHE_DECODE_SIZE;
+            __mapped_primes_decode(&mapped, i, chunk_count, chunk);
+            __bitmap_add_primes(wheel, bitmap->items, chunk, chunk_count);
+        }
+    }
+
+    // the sieve starts fresh, it gets its primes from the sieving prime table, not the file.
+    prime_generator->last_prime_checked = start;
+    prime_generator->sieve.block_start  = start;
+    return true;
+}
+
+
+#ifndef PRIME_GENERATOR_NO_FILES
+
+// the gaps are put in here first, so the file isnt written a byte at a time.
+#define PRIME_GENERATOR_EXPORT_BUFFER_SIZE    (1 << 16)
+
+// internal, what 'export_prime_generator()' hands to 'for_each_prime_in_range()'
+typedef struct Prime_Generator_Exporter {
+    FILE *file;
+    // the chunks go after the gaps, but we dont know how many gaps there are untill the end,
+    // so they wait in a temp file, (there could be more of them than fit in memory)
+    FILE *chunks;
+
+    u64 count;
+    u64 last_prime;
+    u64 gap_count;
+
+    uint8_t buffer[PRIME_GENERATOR_EXPORT_BUFFER_SIZE];
+    u64 buffered;
+
+    bool failed;
+} Prime_Generator_Exporter;
+
+Prime_Generator_Internal bool __exporter_flush(Prime_Generator_Exporter *exporter) {
+    if (exporter->buffered && fwrite(exporter->buffer, 1, exporter->buffered, exporter->file) != exporter->buffered) exporter->failed = true;
+    exporter->buffered = 0;
+    return !exporter->failed;
+}
+
+// the same encoding as '__compressed_primes_append()', just into a file.
+Prime_Generator_Internal bool __export_primes_callback(const u64 *primes, u64 count, void *user_data) {
+    Prime_Generator_Exporter *exporter = user_data;
+
+    for (u64 i = 0; i < count; i++) {
+        u64 prime = primes[i];
+
+        if (exporter->count % PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE == 0) {
+            Prime_Generator_Compressed_Chunk chunk = { .base = prime, .gap_offset = exporter->gap_count };
+            if (fwrite(&chunk, sizeof(chunk), 1, exporter->chunks) != 1) exporter->failed = true;
+        } else {
+            // room for an escaped one.
+            if (exporter->buffered + 3 > PRIME_GENERATOR_EXPORT_BUFFER_SIZE) __exporter_flush(exporter);
+
+            u64 gap = prime - exporter->last_prime;
+            if (gap < 256) {
+                exporter->buffer[exporter->buffered++] = (uint8_t) gap;
+                exporter->gap_count += 1;
+            } else {
+                exporter->buffer[exporter->buffered++] = PRIME_GENERATOR_GAP_ESCAPE;
+                exporter->buffer[exporter->buffered++] = (uint8_t)(gap);
+                exporter->buffer[exporter->buffered++] = (uint8_t)(gap >> 8);
+                exporter->gap_count += 3;
+            }
+        }
+        if (exporter->failed) return false;
+
+        exporter->last_prime = prime;
+        exporter->count += 1;
+    }
+    return true;
+}
+
+#endif // PRIME_GENERATOR_NO_FILES
+
+bool export_prime_generator(Prime_Generator *prime_generator, u64 n, const char *path) {
+    if (!prime_generator || !path) {
         PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(path && "must pass in a path, got NULL");
+        return false;
+    }
+    if (n > (1ULL << 60)) {
+        PRIME_GENERATOR_ASSERT(n <= (1ULL << 60) && "This is getting a little out of hand.");
+        return false;
+    }
+
+    #ifdef PRIME_GENERATOR_NO_FILES
+        return false;
+    #else
+        Prime_Generator_Exporter *exporter = PRIME_GENERATOR_REALLOC(NULL, 0, sizeof(Prime_Generator_Exporter));
+        if (!exporter) {
+            PRIME_GENERATOR_ASSERT(exporter && "You ran out of memory, how?");
+            return false;
+        }
+        PRIME_GENERATOR_MEM_ZERO(exporter, sizeof(*exporter));
+
+        char *temp_path;
+        exporter->file = __open_cache_temp_file(path, &temp_path);
+        if (!exporter->file) {
+            PRIME_GENERATOR_FREE(exporter, sizeof(Prime_Generator_Exporter));
+            return false;
+        }
+        exporter->chunks = tmpfile();
+        exporter->failed = !exporter->chunks;
+
+        // room for the header, it gets filled in at the end, when we know whats in the file.
+        Prime_Generator_Index_Header header = {};
+        if (fwrite(&header, sizeof(header), 1, exporter->file) != 1) exporter->failed = true;
+
+        if (!exporter->failed) for_each_prime_in_range(prime_generator, 0, n, __export_primes_callback, exporter);
+        __exporter_flush(exporter);
+
+        // line the chunks up to 8 bytes, and copy them in after the gaps.
+        u64 chunk_offset = sizeof(header) + exporter->gap_count;
+        u64 padding      = (sizeof(u64) - chunk_offset % sizeof(u64)) % sizeof(u64);
+        PRIME_GENERATOR_MEM_ZERO(exporter->buffer, padding);
+        exporter->buffered = padding;
+        chunk_offset      += padding;
+
+        if (!exporter->failed) {
+            rewind(exporter->chunks);
+            while (__exporter_flush(exporter)) {
+                exporter->buffered = fread(exporter->buffer, 1, PRIME_GENERATOR_EXPORT_BUFFER_SIZE, exporter->chunks);
+                if (exporter->buffered == 0) break;
+            }
+            if (ferror(exporter->chunks)) exporter->failed = true;
+        }
+
+        header = (Prime_Generator_Index_Header){
+            .cache = {
+                .version            = PRIME_GENERATOR_CACHE_VERSION_INDEXED,
+                .count              = exporter->count,
+                .last_prime_checked = n,
+            },
+            .chunk_size   = PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE,
+            .chunk_count  = (exporter->count + PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE - 1) / PRIME_GENERATOR_COMPRESSED_CHUNK_SIZE,
+            .chunk_offset = chunk_offset,
+            .gap_count    = exporter->gap_count,
+        };
+        PRIME_GENERATOR_MEM_COPY(header.cache.magic, PRIME_GENERATOR_CACHE_MAGIC, sizeof(header.cache.magic));
+
+        bool wrote_everything = !exporter->failed
+                             && fseek(exporter->file, 0, SEEK_SET) == 0
+                             && fwrite(&header, sizeof(header), 1, exporter->file) == 1;
+
+        if (exporter->chunks) fclose(exporter->chunks);
+        wrote_everything = __finish_cache_temp_file(exporter->file, temp_path, path, wrote_everything);
+
+        PRIME_GENERATOR_FREE(exporter, sizeof(Prime_Generator_Exporter));
+        return wrote_everything;
+    #endif // PRIME_GENERATOR_NO_FILES
+}
+
+
+
+/////////////////////////////////////////////////
+//              SHARED GENERATOR
+/////////////////////////////////////////////////
+
+bool init_shared_prime_generator(Prime_Generator_Shared *shared, u64 max_n) {
+    if (!shared) {
+        PRIME_GENERATOR_ASSERT(shared);
+        return false;
+    }
+    Prime_Generator *prime_generator = &shared->generator;
+
+    if (prime_generator->storage != PRIME_GENERATOR_STORAGE_U64) {
+        PRIME_GENERATOR_ASSERT(prime_generator->storage == PRIME_GENERATOR_STORAGE_U64 && "the shared generator hands out its array, so it needs PRIME_GENERATOR_STORAGE_U64");
+        return false;
+    }
+    if (prime_generator->wheel || prime_generator->inner_prime_array.count != 0) {
+        PRIME_GENERATOR_ASSERT(!prime_generator->wheel && "the shared generator has to start with a fresh generator, clear it first");
+        return false;
+    }
+    if (max_n > (1ULL << 60)) {
+        PRIME_GENERATOR_ASSERT(max_n <= (1ULL << 60) && "This is getting a little out of hand.");
+        return false;
+    }
+
+    // room for anything generating upto max_n could ask for, the bound is not quite always
+    // bigger for a bigger x, (it switches formulas at 355991) and the first block always gets made.
+    u64 capacity = __prime_count_upper_bound(max_n);
+    u64 smaller  = __prime_count_upper_bound(355990);
+    u64 first    = __prime_count_upper_bound(PRIME_GENERATOR_BLOCK_SIZE + PRIME_GENERATOR_MAX_WHEEL_MODULUS * 64);
+    if (capacity < smaller) capacity = smaller;
+    if (capacity < first)   capacity = first;
+    // a block past max_n, and the extraction writes a little past the end.
+    capacity += PRIME_GENERATOR_BLOCK_BITS + PRIME_GENERATOR_EXTRACT_SLACK + 8;
+
+    if (!Prime_Array_Reserve(&prime_generator->inner_prime_array, capacity)) return false;
+
+    shared->primes          = prime_generator->inner_prime_array.items;
+    shared->max_n           = max_n;
+    shared->published_count = 0;
+    shared->published_upto  = 0;
+
+    #ifndef PRIME_GENERATOR_NO_THREADS
+        pthread_mutex_init(&shared->extend_lock, NULL);
+    #endif // PRIME_GENERATOR_NO_THREADS
+    return true;
+}
+
+void clear_shared_prime_generator(Prime_Generator_Shared *shared) {
+    if (!shared) {
+        PRIME_GENERATOR_ASSERT(shared);
+        return;
+    }
+
+    #ifndef PRIME_GENERATOR_NO_THREADS
+        if (shared->primes) pthread_mutex_destroy(&shared->extend_lock);
+    #endif // PRIME_GENERATOR_NO_THREADS
+
+    clear_prime_generator(&shared->generator);
+    shared->primes          = NULL;
+    shared->max_n           = 0;
+    shared->published_count = 0;
+    shared->published_upto  = 0;
+}
+
+// generate upto 'until' (with the lock) and let the readers see the new primes.
+Prime_Generator_Internal void __extend_shared_prime_generator(Prime_Generator_Shared *shared, u64 until) {
+    Prime_Generator *prime_generator = &shared->generator;
+
+    #ifndef PRIME_GENERATOR_NO_THREADS
+        pthread_mutex_lock(&shared->extend_lock);
+    #endif // PRIME_GENERATOR_NO_THREADS
+
+    // someone else might have done it while we were waiting.
+    if (prime_generator->last_prime_checked < until) {
+        generate_primes_under_n(prime_generator, until);
+
+        if (prime_generator->inner_prime_array.items != shared->primes) {
+            PRIME_GENERATOR_ASSERT(prime_generator->inner_prime_array.items == shared->primes && "the shared generators array moved, this is a bug.");
+        } else {
+            // the count first, anyone who sees the new 'published_upto' sees a count that covers it.
+            PRIME_GENERATOR_ATOMIC_STORE(&shared->published_count, prime_generator->inner_prime_array.count);
+            PRIME_GENERATOR_ATOMIC_STORE(&shared->published_upto,  prime_generator->last_prime_checked);
+        }
+    }
+
+    #ifndef PRIME_GENERATOR_NO_THREADS
+        pthread_mutex_unlock(&shared->extend_lock);
+    #endif // PRIME_GENERATOR_NO_THREADS
+}
+
+u64 get_nth_prime_shared(Prime_Generator_Shared *shared, u64 n) {
+    if (!shared || !shared->primes || n == 0) {
+        PRIME_GENERATOR_ASSERT(shared);
+        PRIME_GENERATOR_ASSERT((!shared || shared->primes) && "call 'init_shared_prime_generator()' first");
         PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
+        return 0;
+    }
+
+    // the fast path, no lock.
+    if (n <= PRIME_GENERATOR_ATOMIC_LOAD(&shared->published_count)) return shared->primes[n-1];
+
+    // the nth prime is under this, (unless its past max_n)
+    u64 until = __nth_prime_upper_bound(n);
+    if (until > shared->max_n) until = shared->max_n;
+    __extend_shared_prime_generator(shared, until);
+
+    if (n > PRIME_GENERATOR_ATOMIC_LOAD(&shared->published_count)) {
+        PRIME_GENERATOR_ASSERT(false && "that prime is past the max_n the shared generator was made with");
+        return 0;
+    }
+    return shared->primes[n-1];
+}
+
+Prime_Array get_all_primes_upto_nth_prime_shared(Prime_Generator_Shared *shared, u64 n) {
+    if (get_nth_prime_shared(shared, n) == 0) return (Prime_Array){};
+    return (Prime_Array){ .count = n, .items = (u64 *) shared->primes };
+}
+
+Prime_Array get_all_primes_under_n_shared(Prime_Generator_Shared *shared, u64 n) {
+    if (!shared || !shared->primes) {
+        PRIME_GENERATOR_ASSERT(shared);
+        PRIME_GENERATOR_ASSERT((!shared || shared->primes) && "call 'init_shared_prime_generator()' first");
         return (Prime_Array){};
     }
+    if (n > shared->max_n) {
+        PRIME_GENERATOR_ASSERT(n <= shared->max_n && "thats past the max_n the shared generator was made with");
+        return (Prime_Array){};
+    }
+
+    if (PRIME_GENERATOR_ATOMIC_LOAD(&shared->published_upto) < n) __extend_shared_prime_generator(shared, n);
+
+    // loaded after 'published_upto', so it has every prime under n.
+    u64 count = PRIME_GENERATOR_ATOMIC_LOAD(&shared->published_count);
+
+    // same binary search as '__prime_generator_count_under()'
+    u64 low  = 0;
+    u64 high = count;
+    while (low < high) {
+        u64 mid = (low + high) / 2;
+        if (shared->primes[mid] < n) low  = mid + 1;
+        else                         high = mid;
+    }
+
+    return (Prime_Array){ .count = low, .items = (u64 *) shared->primes };
+}
+
+
+Prime_Array_U32 get_all_primes_upto_nth_prime_u32(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator || n == 0) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
+        return (Prime_Array_U32){};
+    }
+    if (prime_generator->storage != PRIME_GENERATOR_STORAGE_U32) {
+        PRIME_GENERATOR_ASSERT(prime_generator->storage == PRIME_GENERATOR_STORAGE_U32 && "the *_u32() functions need a generator with PRIME_GENERATOR_STORAGE_U32");
+        return (Prime_Array_U32){};
+    }
+    if (n > PRIME_GENERATOR_PRIMES_UNDER_2_32) {
+        PRIME_GENERATOR_ASSERT(n <= PRIME_GENERATOR_PRIMES_UNDER_2_32 && "that prime dose not fit in 32 bits, use 'get_all_primes_upto_nth_prime()'");
+        return (Prime_Array_U32){};
+    }
 
     generate_primes_until_nth_prime(prime_generator, n);
 
-    Prime_Array result = prime_generator->inner_prime_array;
+    Prime_Array_U32 result = prime_generator->u32_primes;
     result.count = n;
     return result;
 }
 
-Prime_Array get_all_primes_under_n(Prime_Generator *prime_generator, u64 n) {
+Prime_Array_U32 get_all_primes_under_n_u32(Prime_Generator *prime_generator, u64 n) {
     if (!prime_generator) {
         PRIME_GENERATOR_ASSERT(prime_generator);
-        return (Prime_Array){};
+        return (Prime_Array_U32){};
+    }
+    if (prime_generator->storage != PRIME_GENERATOR_STORAGE_U32) {
+        PRIME_GENERATOR_ASSERT(prime_generator->storage == PRIME_GENERATOR_STORAGE_U32 && "the *_u32() functions need a generator with PRIME_GENERATOR_STORAGE_U32");
+        return (Prime_Array_U32){};
+    }
+    if (n > (1ULL << 32)) {
+        PRIME_GENERATOR_ASSERT(n <= (1ULL << 32) && "those primes dont fit in 32 bits, use 'get_all_primes_under_n()'");
+        return (Prime_Array_U32){};
     }
 
     generate_primes_under_n(prime_generator, n);
 
-    Prime_Array result = prime_generator->inner_prime_array;
-
-    // binary search to fund biggest prime smaller than n
-    u64 low = 0;
-    u64 high = result.count-1;
+    Prime_Array_U32 result = prime_generator->u32_primes;
 
+    // same binary search as '__prime_generator_count_under()'
+    u64 low  = 0;
+    u64 high = result.count;
     while (low < high) {
-        // if this tries to overflow, you computer will allready be at 0.0001 FPS
         u64 mid = (low + high) / 2;
-        if      (result.items[mid] < n) low  = mid + 1;
-        else if (result.items[mid] > n) high = mid - 1;
-        else                            break;
-    }
-
-    if (!(low+1 >= result.count || result.items[low+1] >= n)) {
-        PRIME_GENERATOR_ASSERT(low+1 >= result.count || result.items[low+1] >= n);
-        return result; // they'll get the whole array instead.
+        if (result.items[mid] < n) low  = mid + 1;
+        else                       high = mid;
     }
 
     result.count = low;
@@ -540,6 +4229,48 @@ Prime_Array get_all_primes_under_n(Prime_Generator *prime_generator, u64 n) {
 }
 
 
+const u64 *prime_array_chunked_at(Prime_Array_Chunked array, u64 index) {
+    if (index >= array.count) {
+        PRIME_GENERATOR_ASSERT(index < array.count && "thats past the end of the array");
+        return NULL;
+    }
+    u64 chunk, offset;
+    __chunked_primes_locate(index, &chunk, &offset);
+    return &array.chunks[chunk][offset];
+}
+
+Prime_Array_Chunked get_all_primes_upto_nth_prime_chunked(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator || n == 0) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        PRIME_GENERATOR_ASSERT(n != 0 && "this function is 1 indexed");
+        return (Prime_Array_Chunked){};
+    }
+    if (prime_generator->storage != PRIME_GENERATOR_STORAGE_CHUNKED) {
+        PRIME_GENERATOR_ASSERT(prime_generator->storage == PRIME_GENERATOR_STORAGE_CHUNKED && "the *_chunked() functions need a generator with PRIME_GENERATOR_STORAGE_CHUNKED");
+        return (Prime_Array_Chunked){};
+    }
+
+    generate_primes_until_nth_prime(prime_generator, n);
+
+    return (Prime_Array_Chunked){ .count = n, .chunks = prime_generator->chunked.chunks };
+}
+
+Prime_Array_Chunked get_all_primes_under_n_chunked(Prime_Generator *prime_generator, u64 n) {
+    if (!prime_generator) {
+        PRIME_GENERATOR_ASSERT(prime_generator);
+        return (Prime_Array_Chunked){};
+    }
+    if (prime_generator->storage != PRIME_GENERATOR_STORAGE_CHUNKED) {
+        PRIME_GENERATOR_ASSERT(prime_generator->storage == PRIME_GENERATOR_STORAGE_CHUNKED && "the *_chunked() functions need a generator with PRIME_GENERATOR_STORAGE_CHUNKED");
+        return (Prime_Array_Chunked){};
+    }
+
+    generate_primes_under_n(prime_generator, n);
+
+    return (Prime_Array_Chunked){ .count = __prime_generator_count_under(prime_generator, n), .chunks = prime_generator->chunked.chunks };
+}
+
+
 
 
 #endif // PRIME_GENERATOR_IMPLEMENTATION_GUARD_
@@ -68,7 +68,24 @@
     X(test_greater_and_greater_powers_of_10, 1) \
     X(test_get_all_primes_upto_nth_prime,    1) \
     X(test_get_all_primes_under_n,           1) \
+    X(test_sieve_layouts,                    1) \
+    X(test_thread_scaling,                   1) \
+    X(test_isa_dispatch,                     1) \
+    X(test_compressed_storage,               1) \
+    X(test_u32_storage,                      1) \
+    X(test_is_prime,                         1) \
+    X(test_count_primes,                     1) \
+    X(test_primes_in_range,                  1) \
+    X(test_next_and_prev_prime,              1) \
+    X(test_for_each_prime,                   1) \
+    X(test_sieving_prime_table,              1) \
+    X(test_prime_cache,                      1) \
+    X(test_indexed_prime_cache,              1) \
+    X(test_shared_generator,                 1) \
+    X(test_chunked_storage,                  1) \
                                                 \
+    /* these take a while. */                   \
+    X(test_u32_storage_past_2_32,            1) \
     X(test_bench_test,                       1)
 
 
@@ -144,6 +161,69 @@ void print_duration(u64 total_time_in_ns) {
 }
 
 
+// the first 'n' primes, made with 'get_primes_upto_number()', so the
+// generator never gets checked against itself.
+//
+// its kept around for every test, so its only made again if someone wants more.
+Prime_Array reference_primes(u64 n) {
+    static Prime_Array primes = {};
+
+    // the n'th prime is under 25 * n untill n is way bigger than anything we test.
+    u64 upto = (n < 100 ? 100 : n) * 25;
+    while (primes.count < n) {
+        primes.count = 0;
+        get_primes_upto_number(upto, &primes);
+        upto *= 2;
+    }
+    return (Prime_Array){ .count = n, .items = primes.items };
+}
+
+
+// what a test checks on top of the primes being right, its handed the
+// generator right after it made the first 'n' primes.
+typedef bool (*Config_Check)(Prime_Generator *generator, u64 n);
+
+// make the first 'n' primes with every layout, on 1 thread and on 4, (the 2 ways blocks get made)
+// starting from 'config', check them against 'reference_primes()', then do 'check' if there is one.
+//
+// prints a line for each one, returns true if they were all correct.
+bool check_every_config(Prime_Generator config, u64 n, Config_Check check) {
+    bool result = true;
+
+    u64 thread_counts[] = {1, 4};
+    for (u64 layout = 0; layout < PRIME_GENERATOR_LAYOUT_COUNT; layout++) {
+        for (size_t t = 0; t < Array_Len(thread_counts); t++) {
+            Prime_Generator generator = config;
+            generator.layout       = layout;
+            generator.thread_count = thread_counts[t];
+
+            u64 start_t = nanoseconds_since_unspecified_epoch();
+                generate_primes_until_nth_prime(&generator, n);
+            u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+            // 'check' can ask for more reference primes, so get it every time.
+            Prime_Array correct = reference_primes(n);
+            Prime_Array arr     = get_all_primes_upto_nth_prime(&generator, n);
+
+            bool was_correct = (arr.count == n);
+            for (size_t i = 0; was_correct && i < n; i++) {
+                if (arr.items[i] != correct.items[i]) was_correct = false;
+            }
+            if (was_correct && check) was_correct = check(&generator, n);
+
+            printf("    layout %ld, %ld threads: (%s) - time: ", layout, thread_counts[t], was_correct ? "Correct" : "Not Correct");
+            print_duration(end_t - start_t);
+            printf("\n");
+
+            result &= was_correct;
+            clear_prime_generator(&generator);
+        }
+    }
+
+    return result;
+}
+
+
 
 ////////////////////////////////////////////////////
 //                 The Tests
@@ -155,11 +235,21 @@ bool test_get_primes_upto_number(void) {
 
     get_primes_upto_number(1000, &primes);
     printf("primes.count = %ld\n", primes.count);
+    bool result = (primes.count == 168);
+
+    // this used to blow the stack, its segmented now.
+    //
+    // appends to whats allready there, and goes over a bunch of segments.
+    u64 n = 100000000;
+    get_primes_upto_number(n, &primes);
+    printf("primes.count = %ld, last = %ld\n", primes.count, primes.items[primes.count-1]);
+    result &= (primes.count == 168 + 5761455);
+    result &= (primes.items[168] == 2 && primes.items[primes.count-1] == 99999989);
 
     // this is just the nicest way to do
     // thing with the setup I have.
     free(primes.items);
-    return primes.count == 168;
+    return result;
 }
 
 
@@ -214,6 +304,10 @@ bool test_greater_and_greater_powers_of_10(void) {
         {  1000000,   15485863},
         { 10000000,  179424673},
         {100000000, 2038074743}, // 2.968 seconds is my best time. might crash vscode.
+
+        // only 'find_nth_prime()' goes this far, 'get_nth_prime()' would need 80GB.
+        {  10000000000,  252097800623},
+        { 100000000000, 2760727302517},
     };
 
     bool result = true;
@@ -227,15 +321,31 @@ bool test_greater_and_greater_powers_of_10(void) {
         u64 n = pows_of_10[i].n;
         u64 correct = pows_of_10[i].correct;
 
+        if (n <= 100000000) {
+            u64 start_t = nanoseconds_since_unspecified_epoch();
+                u64 prime = get_nth_prime(&generator, n);
+            u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+            bool was_correct = (prime == correct);
+
+            printf("    %12ld: %14ld (%s) - time: ", n, prime, was_correct ? "Correct" : "Not Correct");
+            print_duration(end_t - start_t);
+            printf("\n");
+
+            result &= was_correct;
+            clear_prime_generator(&generator);
+        }
+
+        // and again without keeping the primes.
         u64 start_t = nanoseconds_since_unspecified_epoch();
-            u64 prime = get_nth_prime(&generator, n);
+            u64 prime = find_nth_prime(&generator, n);
         u64 end_t   = nanoseconds_since_unspecified_epoch();
 
         bool was_correct = (prime == correct);
 
-        printf("    %12ld: %12ld (%s) - time: ", n, prime, was_correct ? "Correct" : "Not Correct");
+        printf("    %12ld: %14ld (%s) - time: ", n, prime, was_correct ? "Correct" : "Not Correct");
         print_duration(end_t - start_t);
-        printf("\n");
+        printf(" (find_nth_prime)\n");
 
         result &= was_correct;
     }
@@ -304,6 +414,987 @@ bool test_get_all_primes_under_n(void) {
 
 
 
+// the wheels only keep a cell for the numbers coprime to them.
+bool check_sieve_layout(Prime_Generator *generator, u64 n) {
+    (void) n;
+
+    u64 cells_per_turn[PRIME_GENERATOR_LAYOUT_COUNT] = {
+        [PRIME_GENERATOR_LAYOUT_ODD_ONLY]  =  1,
+        [PRIME_GENERATOR_LAYOUT_WHEEL_30]  =  8,
+        [PRIME_GENERATOR_LAYOUT_WHEEL_210] = 48,
+    };
+    return generator->wheel->residue_count == cells_per_turn[generator->layout];
+}
+
+bool test_sieve_layouts(void) {
+    CLEAR_ARENA();
+
+    u64 n = 10000000;
+    printf("test sieve layouts: n = %ld\n", n);
+
+    return check_every_config((Prime_Generator){ .allocator = &arena }, n, check_sieve_layout);
+}
+
+
+// you get the kernels you asked for, or the best ones the cpu can do if it cant, never AUTO.
+bool check_isa_dispatch(Prime_Generator *generator, u64 n) {
+    (void) n;
+
+    Prime_Generator_Isa ran = generator->wheel->isa;
+    if (ran == PRIME_GENERATOR_ISA_AUTO) return false;
+    return generator->isa == PRIME_GENERATOR_ISA_AUTO || ran <= generator->isa;
+}
+
+bool test_isa_dispatch(void) {
+    CLEAR_ARENA();
+
+    const char *isa_names[PRIME_GENERATOR_ISA_COUNT] = {
+        [PRIME_GENERATOR_ISA_AUTO]     = "auto",
+        [PRIME_GENERATOR_ISA_BASELINE] = "baseline",
+        [PRIME_GENERATOR_ISA_AVX2]     = "avx2",
+        [PRIME_GENERATOR_ISA_AVX512]   = "avx512",
+    };
+
+    u64 n = 1000000;
+
+    bool result = true;
+    for (size_t isa = 0; isa < PRIME_GENERATOR_ISA_COUNT; isa++) {
+        printf("test isa dispatch: %s, n = %ld\n", isa_names[isa], n);
+        result &= check_every_config((Prime_Generator){ .allocator = &arena, .isa = isa }, n, check_isa_dispatch);
+    }
+
+    return result;
+}
+
+
+// the chunk edges decode right, and its really smaller.
+bool check_compressed_storage(Prime_Generator *generator, u64 n) {
+    Prime_Array correct = reference_primes(n);
+
+    // some random ones, and the edges of the chunks.
+    bool result = true;
+    u64 indexes[] = {1, 2, 3, 255, 256, 257, 512, 513, 99999, 1234567, n-1, n};
+    for (size_t i = 0; i < Array_Len(indexes); i++) {
+        result &= (get_nth_prime(generator, indexes[i]) == correct.items[indexes[i]-1]);
+    }
+
+    Prime_Array under = get_all_primes_under_n(generator, 1000000);
+    result &= (under.count == 78498 && under.items[under.count-1] == 999983);
+
+    // about 1 byte a prime, instead of 8.
+    u64 compressed_bytes = generator->compressed.chunk_count * sizeof(Prime_Generator_Compressed_Chunk) + generator->compressed.gap_count;
+    result &= (compressed_bytes < 2 * generator->compressed.count);
+    return result;
+}
+
+bool test_compressed_storage(void) {
+    CLEAR_ARENA();
+
+    u64 n = 2000000;
+    printf("test compressed storage: n = %ld\n", n);
+
+    return check_every_config((Prime_Generator){ .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_COMPRESSED }, n, check_compressed_storage);
+}
+
+
+// the no copy view has the same primes, and stops where it should.
+bool check_u32_storage(Prime_Generator *generator, u64 n) {
+    Prime_Array correct = reference_primes(n);
+
+    Prime_Array_U32 small = get_all_primes_upto_nth_prime_u32(generator, n);
+    bool result = (small.count == n);
+    for (size_t i = 0; result && i < small.count; i++) {
+        if (small.items[i] != correct.items[i]) result = false;
+    }
+
+    Prime_Array_U32 under = get_all_primes_under_n_u32(generator, 1000000);
+    result &= (under.count == 78498 && under.items[under.count-1] == 999983);
+    return result;
+}
+
+bool test_u32_storage(void) {
+    CLEAR_ARENA();
+
+    u64 n = 2000000;
+    printf("test u32 storage: n = %ld\n", n);
+
+    return check_every_config((Prime_Generator){ .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_U32 }, n, check_u32_storage);
+}
+
+
+// the u32 storage going past 2^32 for real, the primes after it go in a u64 array.
+//
+// thats about 203 million primes, (800MB of u32's) so this takes a few seconds.
+bool test_u32_storage_past_2_32(void) {
+    CLEAR_ARENA();
+
+    Prime_Generator generator = { .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_U32, .thread_count = 4 };
+
+    // the biggest prime under 2^32, and the first 2 after it.
+    u64 primes_under_2_32 = 203280221;
+    u64 edge_primes[] = {4294967291, 4294967311, 4294967357};
+
+    u64 lo = (1ULL << 32) - 1000000;
+    u64 hi = (1ULL << 32) + 1000000;
+
+    printf("test u32 storage past 2^32:\n");
+
+    u64 start_t = nanoseconds_since_unspecified_epoch();
+        generate_primes_under_n(&generator, hi);
+    u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+    bool result = true;
+    for (size_t i = 0; i < Array_Len(edge_primes); i++) {
+        result &= (get_nth_prime(&generator, primes_under_2_32 + i) == edge_primes[i]);
+    }
+
+    // the no copy view stops at 2^32.
+    Prime_Array_U32 small = get_all_primes_under_n_u32(&generator, 1ULL << 32);
+    result &= (small.count == primes_under_2_32 && small.items[small.count-1] == edge_primes[0]);
+
+    // a window across 2^32 comes out of both arrays, check it the slow way.
+    Prime_Array window = {};
+    get_primes_in_range(&generator, lo, hi, &window);
+
+    u64 index = 0;
+    for (u64 x = lo | 1; result && x < hi; x += 2) {
+        if (!is_prime_no_generator(x)) continue;
+        if (index >= window.count || window.items[index] != x) result = false;
+        index += 1;
+    }
+    result &= (index == window.count);
+
+    printf("    %ld primes in [2^32 - 10^6, 2^32 + 10^6) (%s) - time: ", window.count, result ? "Correct" : "Not Correct");
+    print_duration(end_t - start_t);
+    printf("\n");
+
+    free(window.items);
+    clear_prime_generator(&generator);
+    return result;
+}
+
+
+bool test_is_prime(void) {
+    CLEAR_ARENA();
+
+    u64 n = 80000000;
+
+    Prime_Array correct = {};
+    get_primes_upto_number(n, &correct);
+
+    printf("test is prime: n = %ld\n", n);
+
+    bool result = true;
+
+    // check every number under n, with and without the bitmap, (the threads fill it in too)
+    //
+    // the binary search is slower, so it only gets the first quarter.
+    for (u64 layout = 0; layout < PRIME_GENERATOR_LAYOUT_COUNT; layout++) {
+        for (u64 keep_bitmap = 0; keep_bitmap <= 1; keep_bitmap++) {
+            Prime_Generator generator = { .allocator = &arena, .layout = layout, .keep_bitmap = keep_bitmap, .thread_count = keep_bitmap ? 4 : 1 };
+            u64 check_upto = keep_bitmap ? n : n / 4;
+            generate_primes_under_n(&generator, check_upto);
+
+            u64 start_t = nanoseconds_since_unspecified_epoch();
+                bool was_correct = true;
+                u64 next = 0;
+                for (u64 i = 0; i < check_upto; i++) {
+                    bool should_be_prime = (next < correct.count && correct.items[next] == i);
+                    if (should_be_prime) next += 1;
+                    if (is_prime(&generator, i) != should_be_prime) was_correct = false;
+                }
+            u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+            printf("    layout %ld, bitmap %ld: ", layout, keep_bitmap);
+            print_duration(end_t - start_t);
+            printf(" (%s)\n", was_correct ? "Correct" : "Not Correct");
+            result &= was_correct;
+
+            clear_prime_generator(&generator);
+        }
+    }
+
+    // past what the generator has, (it hasn't started, so thats everything)
+    Prime_Generator generator = { .allocator = &arena };
+
+    bool was_correct = true;
+    u64 next = 0;
+    for (u64 i = 0; i < 1000000; i++) {
+        bool should_be_prime = (next < correct.count && correct.items[next] == i);
+        if (should_be_prime) next += 1;
+        if (is_prime(&generator, i) != should_be_prime) was_correct = false;
+    }
+
+    u64 big_primes[]     = { 4294967291, 4294967311, 1000000007, 1000000009, 2305843009213693951, 18446744073709551557ULL };
+    // carmichael numbers, and numbers that fool a few of the bases.
+    u64 big_composites[] = { 561, 4294967297, 3215031751, 3825123056546413051, 1000000016000000063, 18446744073709551615ULL };
+    for (size_t i = 0; i < Array_Len(big_primes);     i++) was_correct &=  is_prime(&generator, big_primes[i]);
+    for (size_t i = 0; i < Array_Len(big_composites); i++) was_correct &= !is_prime(&generator, big_composites[i]);
+
+    printf("    past the generator: (%s)\n", was_correct ? "Correct" : "Not Correct");
+    result &= was_correct;
+
+    // every number in a window way up high, against the sieve.
+    u64 lo = (1ULL << 50) - 1000000;
+    Prime_Array window = {};
+    get_primes_in_range(&generator, lo, 1ULL << 50, &window);
+
+    was_correct = true;
+    next = 0;
+    for (u64 i = lo; i < (1ULL << 50); i++) {
+        bool should_be_prime = (next < window.count && window.items[next] == i);
+        if (should_be_prime) next += 1;
+        if (is_prime_no_generator(i) != should_be_prime) was_correct = false;
+    }
+    printf("    under 2^50: %ld primes (%s)\n", window.count, was_correct ? "Correct" : "Not Correct");
+    result &= was_correct;
+
+    // how fast a single query is, right at the top where its the slowest.
+    u64 query_count = 1000000;
+    u64 prime_count = 0;
+    u64 start_t = nanoseconds_since_unspecified_epoch();
+        for (u64 i = 0; i < query_count; i++) prime_count += is_prime_no_generator(18446744073709551557ULL - 2 * i);
+    u64 end_t   = nanoseconds_since_unspecified_epoch();
+    printf("    %ld queries near 2^64, %ld primes, %ldns a query\n", query_count, prime_count, (end_t - start_t) / query_count);
+
+    free(window.items);
+
+    clear_prime_generator(&generator);
+    free(correct.items);
+    return result;
+}
+
+
+bool test_count_primes(void) {
+    CLEAR_ARENA();
+
+    // pi(10^k)
+    u64 correct[] = { 0, 4, 25, 168, 1229, 9592, 78498, 664579, 5761455, 50847534, 455052511, 4118054813, 37607912018, 346065536839 };
+
+    printf("test count primes:\n");
+
+    bool result = true;
+    u64 power_of_10 = 1;
+    for (size_t i = 0; i < Array_Len(correct); i++, power_of_10 *= 10) {
+        // a new one every time, so it cant just count what it allready has.
+        Prime_Generator generator = { .allocator = &arena };
+
+        u64 start_t = nanoseconds_since_unspecified_epoch();
+            u64 count = count_primes_under_n(&generator, power_of_10);
+        u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+        printf("    pi(10^%2zu) = %14ld - time: ", i, count);
+        print_duration(end_t - start_t);
+        printf(" (%s)\n", count == correct[i] ? "Correct" : "Not Correct");
+        result &= (count == correct[i]);
+
+        clear_prime_generator(&generator);
+    }
+
+    // some not so round numbers, against a generator that has all the primes.
+    Prime_Generator reference = { .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_COMPRESSED };
+    generate_primes_under_n(&reference, 300000000);
+
+    u64 tests[] = { (1 << 24) - 1, (1 << 24), (1 << 24) + 1, 123456789, 199999991, 199999992, 268435456, 299999999 };
+    bool was_correct = true;
+    for (size_t i = 0; i < Array_Len(tests); i++) {
+        Prime_Generator generator = { .allocator = &arena };
+        was_correct &= (count_primes_under_n(&generator, tests[i]) == count_primes_under_n(&reference, tests[i]));
+        clear_prime_generator(&generator);
+    }
+    printf("    not so round: (%s)\n", was_correct ? "Correct" : "Not Correct");
+    result &= was_correct;
+
+    clear_prime_generator(&reference);
+    return result;
+}
+
+
+bool test_primes_in_range(void) {
+    CLEAR_ARENA();
+
+    Prime_Generator reference = { .allocator = &arena };
+    Prime_Array correct = get_all_primes_under_n(&reference, 100000000);
+
+    printf("test primes in range:\n");
+
+    struct { u64 lo; u64 hi; } ranges[] = {
+        {        0,       100},
+        {       50,        50},
+        {      100,        50},
+        {   500000,    600000}, // goes over the end of the first block
+        {  1234567,   7654321},
+        { 50000000,  51000000},
+        { 99999000, 100000000},
+    };
+
+    bool result = true;
+    for (u64 layout = 0; layout < PRIME_GENERATOR_LAYOUT_COUNT; layout++) {
+        bool was_correct = true;
+        for (size_t i = 0; i < Array_Len(ranges); i++) {
+            u64 lo = ranges[i].lo, hi = ranges[i].hi;
+
+            // the slow way.
+            u64 first = 0;
+            while (first < correct.count && correct.items[first] < lo) first += 1;
+            u64 last = first;
+            while (last < correct.count && correct.items[last] < hi) last += 1;
+
+            // once with a fresh generator, and once with one that has some of them allready.
+            for (u64 warm = 0; warm <= 1; warm++) {
+                Prime_Generator generator = { .allocator = &arena, .layout = layout };
+                if (warm) generate_primes_under_n(&generator, 3000000);
+
+                Prime_Array primes = {};
+                get_primes_in_range(&generator, lo, hi, &primes);
+
+                bool same = (primes.count == (hi > lo ? last - first : 0));
+                for (size_t j = 0; same && j < primes.count; j++) {
+                    if (primes.items[j] != correct.items[first + j]) same = false;
+                }
+                was_correct &= same;
+
+                free(primes.items);
+                clear_prime_generator(&generator);
+            }
+        }
+        printf("    layout %ld: (%s)\n", layout, was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+    }
+
+    // way up high, check every number in a small window.
+    {
+        Prime_Generator generator = { .allocator = &arena };
+        u64 lo = 1000000000000000, hi = lo + 100000;
+
+        Prime_Array primes = {};
+        get_primes_in_range(&generator, lo, hi, &primes);
+
+        bool was_correct = true;
+        u64 next = 0;
+        for (u64 n = lo; n < hi; n++) {
+            bool listed = (next < primes.count && primes.items[next] == n);
+            if (listed) next += 1;
+            if (listed != is_prime(&generator, n)) was_correct = false;
+        }
+        was_correct &= (next == primes.count);
+
+        // and a bigger one, for the time.
+        Prime_Array more = {};
+        u64 start_t = nanoseconds_since_unspecified_epoch();
+            get_primes_in_range(&generator, lo, lo + 10000000, &more);
+        u64 end_t   = nanoseconds_since_unspecified_epoch();
+        for (size_t j = 0; was_correct && j < primes.count; j++) {
+            if (primes.items[j] != more.items[j]) was_correct = false;
+        }
+
+        printf("    [10^15, 10^15 + 10^7): %ld primes - time: ", more.count);
+        print_duration(end_t - start_t);
+        printf(" (%s)\n", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+
+        free(primes.items);
+        free(more.items);
+        clear_prime_generator(&generator);
+    }
+
+    clear_prime_generator(&reference);
+    return result;
+}
+
+
+bool test_next_and_prev_prime(void) {
+    CLEAR_ARENA();
+
+    u64 n = 10000000;
+    Prime_Generator reference = { .allocator = &arena };
+    Prime_Array correct = get_all_primes_under_n(&reference, n);
+
+    printf("test next and prev prime:\n");
+
+    bool result = true;
+
+    // once looking them up, once without the primes.
+    for (u64 warm = 0; warm <= 1; warm++) {
+        Prime_Generator generator = { .allocator = &arena };
+        if (warm) generate_primes_under_n(&generator, n);
+
+        bool was_correct = true;
+        u64 index = 0;
+        for (u64 x = 2; x < correct.items[correct.count-1]; x += 7) {
+            while (correct.items[index] < x) index += 1;
+
+            u64 next = correct.items[index];
+            u64 prev = (correct.items[index] == x) ? x : correct.items[index-1];
+            if (next_prime(&generator, x) != next) was_correct = false;
+            if (prev_prime(&generator, x) != prev) was_correct = false;
+        }
+        was_correct &= (next_prime(&generator, 0) == 2 && next_prime(&generator, 1) == 2);
+        was_correct &= (prev_prime(&generator, 2) == 2 && prev_prime(&generator, 3) == 3);
+        // nothing under 2, that just gives back 0.
+        was_correct &= (prev_prime(&generator, 0) == 0 && prev_prime(&generator, 1) == 0);
+
+        printf("    %s: (%s)\n", warm ? "from the cache" : "no cache      ", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    // way up high.
+    Prime_Generator generator = { .allocator = &arena };
+
+    u64 start_t = nanoseconds_since_unspecified_epoch();
+        bool was_correct = true;
+        was_correct &= (next_prime(&generator, 1000000000000000000) == 1000000000000000003);
+        was_correct &= (prev_prime(&generator, 1000000000000000000) ==  999999999999999989);
+        was_correct &= (next_prime(&generator, 18446744073709551000ULL) == 18446744073709551113ULL);
+        was_correct &= (next_prime(&generator, 18446744073709551536ULL) == 18446744073709551557ULL);
+        was_correct &= (prev_prime(&generator, 18446744073709551615ULL) == 18446744073709551557ULL);
+        // and nothing after the biggest one.
+        was_correct &= (next_prime(&generator, 18446744073709551558ULL) == 0);
+        was_correct &= (next_prime(&generator, 18446744073709551615ULL) == 0);
+    u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+    printf("    near 10^18 and 2^64: (%s) - time: ", was_correct ? "Correct" : "Not Correct");
+    print_duration(end_t - start_t);
+    printf("\n");
+    result &= was_correct;
+
+    clear_prime_generator(&generator);
+    clear_prime_generator(&reference);
+    return result;
+}
+
+
+typedef struct Prime_Sum {
+    u64 count;
+    u64 sum;
+    // stop after this many calls, 0 to never stop.
+    u64 calls_left;
+} Prime_Sum;
+
+bool sum_primes_callback(const u64 *primes, u64 count, void *user_data) {
+    Prime_Sum *prime_sum = user_data;
+    for (u64 i = 0; i < count; i++) prime_sum->sum += primes[i];
+    prime_sum->count += count;
+
+    if (prime_sum->calls_left == 0) return true;
+    return --prime_sum->calls_left != 0;
+}
+
+bool test_for_each_prime(void) {
+    CLEAR_ARENA();
+
+    printf("test for each prime:\n");
+
+    bool result = true;
+
+    // project euler #10
+    {
+        Prime_Generator generator = { .allocator = &arena };
+        Prime_Sum prime_sum = {};
+        for_each_prime_in_range(&generator, 0, 2000000, sum_primes_callback, &prime_sum);
+
+        bool was_correct = (prime_sum.sum == 142913828922);
+        printf("    sum under 2 * 10^6: %ld (%s)\n", prime_sum.sum, was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    // all the way to 10^9, only keeping the primes upto sqrt(10^9)
+    {
+        Prime_Generator generator = { .allocator = &arena };
+        Prime_Sum prime_sum = {};
+
+        u64 start_t = nanoseconds_since_unspecified_epoch();
+            for_each_prime_in_range(&generator, 0, 1000000000, sum_primes_callback, &prime_sum);
+        u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+        bool was_correct = (prime_sum.count == 50847534 && prime_sum.sum == 24739512092254535);
+        // the generator is an array of the primes it kept, its only got the sieving ones.
+        was_correct &= (generator.count < 100000);
+        printf("    sum under 10^9: %ld, %ld primes, (%ld kept) - time: ", prime_sum.sum, prime_sum.count, generator.count);
+        print_duration(end_t - start_t);
+        printf(" (%s)\n", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    // from a compressed cache, then sieving past it, and stopping early.
+    {
+        Prime_Generator generator = { .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_COMPRESSED };
+        generate_primes_under_n(&generator, 10000000);
+
+        Prime_Sum prime_sum = {};
+        for_each_prime_in_range(&generator, 0, 20000000, sum_primes_callback, &prime_sum);
+        bool was_correct = (prime_sum.count == 1270607);
+
+        prime_sum = (Prime_Sum){ .calls_left = 1 };
+        for_each_prime_in_range(&generator, 30000000, 40000000, sum_primes_callback, &prime_sum);
+        was_correct &= (prime_sum.count > 0 && prime_sum.count < 1000000 && prime_sum.calls_left == 0);
+
+        printf("    compressed, and stopping early: (%s)\n", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    return result;
+}
+
+
+// the sieve gets its primes from its own table, never from the primes the generator keeps,
+// so a compressed generator, (witch cant hand its primes out as an array) sieves fine.
+bool check_sieving_prime_table(Prime_Generator *generator, u64 n) {
+    u64 biggest = reference_primes(n).items[n-1];
+
+    // only the primes upto about sqrt of the last block, (the table starts at 2^16, so 6542 of them)
+    bool result = (generator->sieving_prime_table.count < 10000);
+    result &= (generator->sieving_prime_limit * generator->sieving_prime_limit > biggest);
+    return result;
+}
+
+bool test_sieving_prime_table(void) {
+    CLEAR_ARENA();
+
+    u64 n = 2000000;
+    printf("test sieving prime table: n = %ld\n", n);
+
+    bool result = check_every_config((Prime_Generator){ .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_COMPRESSED }, n, check_sieving_prime_table);
+
+    // way past anything the generator has, the table is all there is to sieve with.
+    {
+        Prime_Generator generator = { .allocator = &arena };
+
+        u64 lo = 1000000000000;
+        u64 hi = lo + 1000000;
+
+        Prime_Array range = {};
+        get_primes_in_range(&generator, lo, hi, &range);
+
+        u64 index = 0;
+        bool was_correct = true;
+        for (u64 x = lo | 1; was_correct && x < hi; x += 2) {
+            if (!is_prime_no_generator(x)) continue;
+            if (index >= range.count || range.items[index] != x) was_correct = false;
+            index += 1;
+        }
+        was_correct &= (index == range.count);
+
+        // the primes upto sqrt(hi) = 10^6, (78498 of them) and not a whole lot more.
+        was_correct &= (generator.sieving_prime_table.count >= 78498 && generator.sieving_prime_table.count < 2 * 78498);
+
+        printf("    10^12 + [0, 10^6): %ld primes, %ld sieving primes (%s)\n", range.count, generator.sieving_prime_table.count, was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+
+        free(range.items);
+        clear_prime_generator(&generator);
+    }
+
+    return result;
+}
+
+
+bool test_prime_cache(void) {
+    CLEAR_ARENA();
+
+    const char *path = "test_primes.cache";
+
+    u64 n = 20000000;
+    Prime_Generator reference = { .allocator = &arena };
+    Prime_Array correct = get_all_primes_under_n(&reference, n);
+
+    printf("test prime cache:\n");
+
+    bool result = true;
+
+    // make the file, from a compressed generator, so the saving has to decode.
+    {
+        Prime_Generator generator = { .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_COMPRESSED };
+        generate_primes_under_n(&generator, n / 2);
+        bool was_correct = save_prime_generator(&generator, path);
+        printf("    saved %ld primes: (%s)\n", get_all_primes_under_n(&generator, n / 2).count, was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    for (u64 layout = 0; layout < PRIME_GENERATOR_LAYOUT_COUNT; layout++) {
+        // the bitmap has to be rebuilt from the file.
+        Prime_Generator generator = { .allocator = &arena, .layout = layout, .keep_bitmap = (layout == 1), .thread_count = 4 };
+
+        u64 start_t = nanoseconds_since_unspecified_epoch();
+            bool was_correct = load_prime_generator(&generator, path);
+        u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+        // straight out of the file, the generator itself has nothing yet.
+        Prime_Array from_file = get_all_primes_under_n(&generator, n / 4);
+        was_correct &= (generator.storage == PRIME_GENERATOR_STORAGE_MAPPED && generator.count == 0);
+        was_correct &= (from_file.count == get_all_primes_under_n(&reference, n / 4).count);
+        for (size_t j = 0; was_correct && j < from_file.count; j++) {
+            if (from_file.items[j] != correct.items[j]) was_correct = false;
+        }
+
+        // and past it.
+        Prime_Array primes = get_all_primes_under_n(&generator, n);
+        was_correct &= (primes.count == correct.count);
+        for (size_t j = 0; was_correct && j < primes.count; j++) {
+            if (primes.items[j] != correct.items[j]) was_correct = false;
+        }
+        for (u64 x = n / 2 - 1000; was_correct && x < n / 2 + 1000; x++) {
+            if (is_prime(&generator, x) != is_prime_no_generator(x)) was_correct = false;
+        }
+
+        printf("    layout %ld: load time: ", layout);
+        print_duration(end_t - start_t);
+        printf(" (%s)\n", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+
+        // clearing it makes it a normal generator again.
+        clear_prime_generator(&generator);
+        result &= (generator.storage == PRIME_GENERATOR_STORAGE_U64);
+    }
+
+    // no file, and a file thats not a cache, the generator still works.
+    {
+        Prime_Generator generator = { .allocator = &arena };
+        bool was_correct = !load_prime_generator(&generator, "this_file_does_not_exist.cache");
+
+        FILE *file = fopen(path, "wb");
+        fprintf(file, "not a cache file, just some text thats long enough to have a header.");
+        fclose(file);
+        was_correct &= !load_prime_generator(&generator, path);
+
+        was_correct &= (get_nth_prime(&generator, 1000000) == 15485863);
+        printf("    bad files: (%s)\n", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    remove(path);
+    clear_prime_generator(&reference);
+    return result;
+}
+
+
+bool test_indexed_prime_cache(void) {
+    CLEAR_ARENA();
+
+    const char *path = "test_primes.index";
+
+    u64 n = 20000000;
+    Prime_Generator reference = { .allocator = &arena };
+    Prime_Array correct = get_all_primes_under_n(&reference, 2 * n);
+
+    printf("test indexed prime cache:\n");
+
+    bool result = true;
+
+    {
+        Prime_Generator generator = { .allocator = &arena };
+        bool was_correct = export_prime_generator(&generator, n, path);
+        // it streams them, so it dosent keep them.
+        was_correct &= (generator.count < 100000);
+        printf("    exported the primes under %ld: (%s)\n", n, was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    u64 primes_under_n = get_all_primes_under_n(&reference, n).count;
+
+    for (u64 layout = 0; layout < PRIME_GENERATOR_LAYOUT_COUNT; layout++) {
+        Prime_Generator generator = { .allocator = &arena, .layout = layout, .keep_bitmap = (layout == 2) };
+        bool was_correct = load_prime_generator(&generator, path);
+
+        // out of the file, one chunk at a time, (it gets cut off at a whole word of the layout, so not the last few)
+        for (u64 i = 1; was_correct && i <= primes_under_n - 1000; i += 997) {
+            if (get_nth_prime(&generator, i) != correct.items[i-1]) was_correct = false;
+        }
+        was_correct &= (generator.count == 0);
+        was_correct &= (get_nth_prime(&generator, primes_under_n) == correct.items[primes_under_n-1]);
+        was_correct &= (count_primes_under_n(&generator, n / 2) == get_all_primes_under_n(&reference, n / 2).count);
+
+        Prime_Array range = {};
+        get_primes_in_range(&generator, n / 2, n / 2 + 100000, &range);
+        u64 first = get_all_primes_under_n(&reference, n / 2).count;
+        was_correct &= (range.count == get_all_primes_under_n(&reference, n / 2 + 100000).count - first);
+        for (size_t j = 0; was_correct && j < range.count; j++) {
+            if (range.items[j] != correct.items[first + j]) was_correct = false;
+        }
+        free(range.items);
+
+        for (u64 x = n / 2; was_correct && x < n / 2 + 1000; x++) {
+            if (is_prime(&generator, x) != is_prime_no_generator(x)) was_correct = false;
+        }
+
+        // and past the end of it.
+        Prime_Array primes = get_all_primes_under_n(&generator, 2 * n);
+        was_correct &= (primes.count == correct.count);
+        for (size_t j = 0; was_correct && j < primes.count; j++) {
+            if (primes.items[j] != correct.items[j]) was_correct = false;
+        }
+
+        printf("    layout %ld: (%s)\n", layout, was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    // files with the chunks messed up, and cut off ones, none of them load, the generator still works.
+    {
+        Prime_Generator generator = { .allocator = &arena };
+        bool was_correct = export_prime_generator(&generator, 1000000, path);
+        clear_prime_generator(&generator);
+
+        FILE *file = fopen(path, "rb");
+        fseek(file, 0, SEEK_END);
+        size_t size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        uint8_t *good = malloc(size);
+        uint8_t *bad  = malloc(size);
+        was_correct &= (fread(good, 1, size, file) == size);
+        fclose(file);
+
+        Prime_Generator_Index_Header header;
+        memcpy(&header, good, sizeof(header));
+        was_correct &= (header.chunk_count > 3);
+
+        for (u64 kind = 0; was_correct && kind < 6; kind++) {
+            memcpy(bad, good, size);
+            Prime_Generator_Compressed_Chunk *chunks = (Prime_Generator_Compressed_Chunk *)(bad + header.chunk_offset);
+            size_t bad_size = size;
+            switch (kind) {
+                case 0: chunks[2].gap_offset = header.gap_count + 1;               break; // past the gaps
+                case 1: chunks[2].gap_offset = chunks[1].gap_offset - 1;           break; // going backwards
+                case 2: chunks[0].gap_offset = 1;                                  break; // not starting at 0
+                case 3: chunks[2].base       = chunks[1].base;                     break; // primes not going up
+                case 4: chunks[header.chunk_count-1].gap_offset = header.gap_count; break; // no room for the last chunk
+                case 5: bad_size = header.chunk_offset - 1;                        break; // cut off
+            }
+            file = fopen(path, "wb");
+            fwrite(bad, 1, bad_size, file);
+            fclose(file);
+            if (load_prime_generator(&generator, path)) was_correct = false;
+        }
+        free(good);
+        free(bad);
+
+        was_correct &= (get_nth_prime(&generator, 1000000) == 15485863);
+        printf("    bad files: (%s)\n", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    // a bigger one, for the time.
+    {
+        u64 big_n = 1000000000;
+        Prime_Generator generator = { .allocator = &arena };
+
+        u64 start_t = nanoseconds_since_unspecified_epoch();
+            bool was_correct = export_prime_generator(&generator, big_n, path);
+        u64 end_t   = nanoseconds_since_unspecified_epoch();
+        clear_prime_generator(&generator);
+
+        printf("    export under 10^9: ");
+        print_duration(end_t - start_t);
+        printf("\n");
+
+        was_correct &= load_prime_generator(&generator, path);
+
+        u64 lookups = 100000;
+        u64 index   = 1;
+        u64 sum     = 0;
+        start_t = nanoseconds_since_unspecified_epoch();
+            for (u64 i = 0; i < lookups; i++) {
+                // jump all over the file.
+                index = (index * 6364136223846793005ULL + 1442695040888963407ULL);
+                sum += get_nth_prime(&generator, 1 + (index >> 11) % 50847534);
+            }
+        end_t   = nanoseconds_since_unspecified_epoch();
+
+        was_correct &= (sum != 0 && get_nth_prime(&generator, 50847534) == 999999937);
+        was_correct &= (count_primes_under_n(&generator, big_n) == 50847534);
+
+        printf("    %ld random get_nth_prime()'s: ", lookups);
+        print_duration(end_t - start_t);
+        printf(" (%s)\n", was_correct ? "Correct" : "Not Correct");
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    remove(path);
+    clear_prime_generator(&reference);
+    return result;
+}
+
+
+typedef struct Shared_Test_Thread {
+    Prime_Generator_Shared *shared;
+    const Prime_Array *correct;
+    u64 seed;
+    bool was_correct;
+} Shared_Test_Thread;
+
+void *shared_test_thread_main(void *arg) {
+    Shared_Test_Thread *thread = arg;
+    const Prime_Array *correct = thread->correct;
+
+    u64 state = thread->seed;
+    thread->was_correct = true;
+
+    // the first one, to check it never moves.
+    Prime_Array first = get_all_primes_under_n_shared(thread->shared, 1000);
+
+    for (u64 i = 0; i < 2000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        // further and further out, so the threads keep running into each other extending it.
+        u64 n = 1 + (state >> 11) % (correct->count * (i + 1) / 2000);
+
+        if (get_nth_prime_shared(thread->shared, n) != correct->items[n-1]) thread->was_correct = false;
+
+        if (i % 16 == 0) {
+            u64 upto = correct->items[n-1] + 1;
+            Prime_Array primes = get_all_primes_under_n_shared(thread->shared, upto);
+            if (primes.count != n || primes.items[n-1] != correct->items[n-1]) thread->was_correct = false;
+            if (primes.items != first.items) thread->was_correct = false;
+        }
+    }
+    return NULL;
+}
+
+bool test_shared_generator(void) {
+    CLEAR_ARENA();
+
+    u64 n = 200000000;
+    Prime_Generator reference = { .allocator = &arena };
+    Prime_Array correct = get_all_primes_under_n(&reference, n);
+
+    printf("test shared generator:\n");
+
+    bool result = true;
+
+    // once with the generator on 1 thread, and once with it using threads of its own.
+    u64 generator_threads[] = {1, 4};
+    for (size_t g = 0; g < Array_Len(generator_threads); g++) {
+        Prime_Generator_Shared shared = { .generator = { .allocator = &arena, .thread_count = generator_threads[g] } };
+        bool was_correct = init_shared_prime_generator(&shared, n);
+
+        Shared_Test_Thread threads[8];
+        pthread_t handles[Array_Len(threads)];
+
+        u64 start_t = nanoseconds_since_unspecified_epoch();
+            for (size_t i = 0; i < Array_Len(threads); i++) {
+                threads[i] = (Shared_Test_Thread){ .shared = &shared, .correct = &correct, .seed = i + 1 };
+                pthread_create(&handles[i], NULL, shared_test_thread_main, &threads[i]);
+            }
+            for (size_t i = 0; i < Array_Len(threads); i++) {
+                pthread_join(handles[i], NULL);
+                was_correct &= threads[i].was_correct;
+            }
+        u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+        Prime_Array all = get_all_primes_under_n_shared(&shared, n);
+        was_correct &= (all.count == correct.count && all.items[all.count-1] == correct.items[correct.count-1]);
+
+        printf("    %ld readers, generator on %ld threads: (%s) - time: ", Array_Len(threads), generator_threads[g], was_correct ? "Correct" : "Not Correct");
+        print_duration(end_t - start_t);
+        printf("\n");
+        result &= was_correct;
+
+        clear_shared_prime_generator(&shared);
+        result &= (shared.generator.thread_count == generator_threads[g]);
+    }
+
+    clear_prime_generator(&reference);
+    return result;
+}
+
+
+// views into the chunks stay put while the generator keeps going.
+bool check_chunked_storage(Prime_Generator *generator, u64 n) {
+    Prime_Array correct = reference_primes(2 * n);
+
+    // hang on to some primes, then make a lot more.
+    Prime_Array_Chunked early = get_all_primes_under_n_chunked(generator, 1000000);
+    const u64 *first = prime_array_chunked_at(early, 0);
+    const u64 *last  = prime_array_chunked_at(early, early.count - 1);
+
+    get_nth_prime(generator, 2 * n);
+
+    // nothing moved.
+    bool result = (early.count == 78498 && *first == 2 && *last == 999983);
+    result &= (first == prime_array_chunked_at(early, 0));
+
+    // a chunk at a time.
+    Prime_Array_Chunked primes = get_all_primes_upto_nth_prime_chunked(generator, 2 * n);
+    u64 index = 0;
+    for (u64 k = 0; result && index < primes.count; k++) {
+        u64 in_chunk = (u64) PRIME_GENERATOR_FIRST_CHUNK_SIZE << k;
+        for (u64 j = 0; j < in_chunk && index < primes.count; j++, index++) {
+            if (primes.chunks[k][j] != correct.items[index]) { result = false; break; }
+        }
+    }
+
+    // and the normal functions still work, (they decode a copy)
+    Prime_Array copy = get_all_primes_under_n(generator, 1000000);
+    result &= (copy.count == early.count && copy.items[copy.count-1] == 999983);
+
+    u64 biggest = correct.items[2*n - 1];
+    for (u64 x = biggest - 1000; result && x <= biggest; x++) {
+        if (is_prime(generator, x) != is_prime_no_generator(x)) result = false;
+    }
+    return result;
+}
+
+bool test_chunked_storage(void) {
+    CLEAR_ARENA();
+
+    u64 n = 2000000;
+    printf("test chunked storage: n = %ld\n", n);
+
+    // make the reference big enough up front, so its not made again for every config.
+    reference_primes(2 * n);
+
+    return check_every_config((Prime_Generator){ .allocator = &arena, .storage = PRIME_GENERATOR_STORAGE_CHUNKED }, n, check_chunked_storage);
+}
+
+
+bool test_thread_scaling(void) {
+    CLEAR_ARENA();
+
+    u64 thread_counts[] = {1, 2, 4, 8, 16};
+
+    u64 n = 10000000;
+    u64 correct = 179424673;
+
+    bool result = true;
+
+    printf("test thread scaling: n = %ld\n", n);
+    for (size_t i = 0; i < Array_Len(thread_counts); i++) {
+        Prime_Generator generator = { .allocator = &arena, .thread_count = thread_counts[i] };
+
+        u64 start_t = nanoseconds_since_unspecified_epoch();
+            u64 prime = get_nth_prime(&generator, n);
+        u64 end_t   = nanoseconds_since_unspecified_epoch();
+
+        // make sure the threads didn't mix anything up.
+        Prime_Array arr = get_all_primes_upto_nth_prime(&generator, n);
+        bool in_order = true;
+        for (size_t j = 1; j < arr.count; j++) {
+            if (arr.items[j-1] >= arr.items[j]) { in_order = false; break; }
+        }
+
+        bool was_correct = (prime == correct) && in_order;
+
+        printf("    %2ld threads: %12ld (%s) - time: ", thread_counts[i], prime, was_correct ? "Correct" : "Not Correct");
+        print_duration(end_t - start_t);
+        printf("\n");
+
+        result &= was_correct;
+        clear_prime_generator(&generator);
+    }
+
+    return result;
+}
+
+
+
 
 bool test_bench_test(void) {
     CLEAR_ARENA();